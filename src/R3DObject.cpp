@@ -17,6 +17,7 @@
 //Realio
 #include "R3DObject.h"
 #include "RCamera.h"
+#include "RShaderCache.h"
 #include <iostream>
 
 namespace Realio {
@@ -27,16 +28,13 @@ R3DObject::R3DObject()
     m_textured = false;
 
     m_shader = nullptr;
+    m_shaderVariant = SHADER_PLAIN;
     createShaders();
 }
 
 R3DObject::~R3DObject()
 {
-    if(m_shader)
-    {
-        m_shader->deleteProgram();
-        delete m_shader;
-    }
+    RShaderCache::release(m_shader);
 }
 void R3DObject::translate(glm::vec3 vec)
 {
@@ -81,120 +79,18 @@ void R3DObject::draw()
 
 void R3DObject::createShaders()
 {
-    if(m_shader != nullptr)
-    {
-        m_shader->deleteProgram();
-        delete m_shader;
-    }
-
-    //Object colored and textured
-    if(m_colored && m_textured)
-    {
-        const char vShader[] = {
-            "#version 330 core\n"
-            "layout (location = 0) in vec3 position;"
-            "layout (location = 1) in vec2 texCoord;"
-            "out vec2 TexCoord;"
-            "uniform mat4 model;"
-            "uniform mat4 view;"
-            "uniform mat4 projection;"
-            "void main() {"
-            "    gl_Position = projection * view * model * vec4(position, 1.0f);"
-            "    TexCoord = vec2(texCoord.x, 1.0 - texCoord.y);"
-            "}"
-        };
-
-        const char fShader[] = {
-            "#version 330 core\n"
-            "in vec2 TextCoord;"
-            "out vec4 color;"
-            "uniform sampler2D Texture;"
-            "uniform vec4 Color;"
-            "void main() {"
-            "    color = texture(Texture, TexCoord) * Color;"
-            "}"
-        };
-
-        m_shader = new RShader(vShader, fShader);
-    }
-    //Object textured, but not colored
-    else if(m_textured)
-    {
-        const char vShader[] = {
-            "#version 330 core\n"
-            "layout (location = 0) in vec3 position;"
-            "layout (location = 1) in vec2 texCoord;"
-            "out vec2 TexCoord;"
-            "uniform mat4 model;"
-            "uniform mat4 view;"
-            "uniform mat4 projection;"
-            "void main() {"
-            "    gl_Position = projection * view * model * vec4(position, 1.0f);"
-            "    TexCoord = vec2(texCoord.x, 1.0 - texCoord.y);"
-            "}"
-        };
-
-        const char fShader[] = {
-            "#version 330 core\n"
-            "in vec2 TexCoord;"
-            "out vec4 color;"
-            "uniform sampler2D Texture;"
-            "void main() {"
-            "    color = texture(Texture, TexCoord).rgba;"
-            "}"
-        };
-
-        m_shader = new RShader(vShader, fShader);
-    }
-    //Object colored, but not textured
-    else if(m_colored)
-    {
-        const char vShader[] = {
-            "#version 330 core\n"
-            "layout (location = 0) in vec3 position;"
-            "out vec2 TexCoord;"
-            "uniform mat4 model;"
-            "uniform mat4 view;"
-            "uniform mat4 projection;"
-            "void main() {"
-            "    gl_Position = projection * view * model * vec4(position, 1.0f);"
-            "}"
-        };
-
-        const char fShader[] = {
-            "#version 330 core\n"
-            "out vec4 color;"
-            "uniform vec4 Color;"
-            "void main() {"
-            "    color = Color;"
-            "}"
-        };
-
-        m_shader = new RShader(vShader, fShader);
-    }
-    else
-    {
-        const char vShader[] = {
-            "#version 330 core\n"
-            "layout (location = 0) in vec3 position;"
-            "layout (location = 1) in vec2 texCoord;"
-            "out vec2 TexCoord;"
-            "void main() {"
-            "    gl_Position = vec4(position, 1.0f);"
-            "    TexCoord = vec2(texCoord.x, 1.0 - texCoord.y);"
-            "}"
-        };
-        const char fShader[] = {
-            "#version 330 core\n"
-            "in vec2 TexCoord;"
-            "out vec4 color;"
-            "uniform sampler2D tex;"
-            "void main() {"
-            "    color = texture(tex, TexCoord).rgba;"
-            "}"
-        };
-
-        m_shader = new RShader(vShader, fShader);
-    }
+    unsigned variant = SHADER_PLAIN;
+    if(m_colored)
+        variant |= SHADER_COLORED;
+    if(m_textured)
+        variant |= SHADER_TEXTURED;
+
+    // Already using the right program
+    if(m_shader != nullptr && variant == m_shaderVariant)
+        return;
+
+    RShaderCache::release(m_shader);
+    m_shader = RShaderCache::acquire(variant);
+    m_shaderVariant = variant;
 }
 }
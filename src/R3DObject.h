@@ -85,12 +85,14 @@ public:
 protected:
     glm::mat4 m_modelMatrix;
     RShader *m_shader;
+    unsigned m_shaderVariant;
 
     bool m_colored;
     bool m_textured;
 
     /**
-     * @brief creates shaders. Call it only once!
+     * @brief takes the program of the current variant from RShaderCache.
+     * Cheap to call again, if the variant is the same.
      * @param void.
      * @return void.
      */
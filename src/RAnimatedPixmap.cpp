@@ -16,8 +16,16 @@
 
 //Realio
 #include "RAnimatedPixmap.h"
+#include "RAssetPack.h"
+#include "RGLState.h"
+#include "RImageLoader.h"
+#include "RMemoryTracker.h"
+#include "RMipmapBuilder.h"
+#include "RProfiler.h"
+#include "RTextureUploader.h"
 //C++
 #include <iostream>
+#include <string>
 //STB
 #include "stb/stb_image.h"
 
@@ -50,22 +58,34 @@ RAnimatedPixmap::~RAnimatedPixmap()
 {
     for(unsigned i = 0; i < m_images.size(); ++i)
     {
-        stbi_image_free(m_images[i]->image);
+        if(m_images[i]->ticket)
+            RImageLoader::cancel(m_images[i]->ticket);
+        if(m_images[i]->upload)
+            RTextureUploader::cancel(m_images[i]->upload);
+        freeFrame(m_images[i]);
+        if(m_images[i]->texture)
+            RGLState::deleteTexture(m_images[i]->texture);
         delete m_images.at(i);
     }
 
+    // Frames' textures are deleted already
+    m_texture = 0;
     imgLoaded = false;
 }
 
 bool RAnimatedPixmap::loadFile(const char *file)
 {
     Image *img = new Image;
-    img->image = stbi_load(file, &img->w, &img->h, &img->comp, STBI_rgb_alpha);
+    std::string error;
+    {
+        REALIO_PROFILE_ZONE("stbi_load");
+        img->image = RAssetPack::loadImage(file, img->w, img->h, img->comp, error);
+    }
 
     if(!img->image)
     {
         std::cerr << "Could not load image '" << file << "' to RAnimatedPixmap: ";
-        std::cerr << stbi_failure_reason() << std::endl;
+        std::cerr << error << std::endl;
         delete img;
         return imgLoaded;
     }
@@ -73,6 +93,16 @@ bool RAnimatedPixmap::loadFile(const char *file)
         imgLoaded = true;
 
     img->index = m_images.size();
+    img->texture = 0;
+    img->ticket = 0;
+    img->upload = 0;
+
+    RMemoryTracker::allocate(MEMORY_DECODED_IMAGES, (uintptr_t)img->image,
+                             img->w * img->h * 4, getID());
+
+    img->mips = nullptr;
+    if(RMipmapBuilder::isEnabled())
+        img->mips = RMipmapBuilder::build(img->image, img->w, img->h, getID());
 
     m_images.push_back(img);
 
@@ -82,11 +112,36 @@ bool RAnimatedPixmap::loadFile(const char *file)
     return imgLoaded;
 }
 
+std::shared_future<bool> RAnimatedPixmap::loadFileAsync(const char *file,
+                                                        void (*callback)(RPixmap *pixmap, bool loaded))
+{
+    // The frame keeps its place, however long it decodes
+    Image *img = new Image;
+    img->image = nullptr;
+    img->mips = nullptr;
+    img->w = img->h = img->comp = 0;
+    img->index = m_images.size();
+    img->texture = 0;
+    img->upload = 0;
+
+    m_images.push_back(img);
+
+    imgLoaded = true;
+    m_textured = true;
+    m_colored = false;
+
+    return RImageLoader::request(this, file, callback, img->ticket);
+}
+
 /*virtual*/ void RAnimatedPixmap::show()
 {
+    m_shown = true;
+
     if(!imgLoaded)
         return;
 
+    REALIO_PROFILE_ZONE("RAnimatedPixmap::show");
+
     Image *img = m_images[currentFrame];
 
     if(!m_height && !m_width)
@@ -96,30 +151,136 @@ bool RAnimatedPixmap::loadFile(const char *file)
     }
 
     createShaders();
-    initializeVertices();
+    markDirty();
 
-    glGenTextures(1, &m_texture);
-    glBindTexture(GL_TEXTURE_2D, m_texture);
+    // The frame is still decoding
+    if(img->ticket)
+    {
+        m_texture = RImageLoader::getPlaceholder();
+        m_placeholder = true;
+        update();
+        return;
+    }
+
+    // The last complete frame is drawn, until this one is streamed
+    if(!img->texture && RTextureUploader::isEnabled())
+    {
+        if(!img->upload)
+        {
+            img->upload = RTextureUploader::enqueue(this, img->image, img->w, img->h, img->mips);
+            img->image = nullptr;
+            img->mips = nullptr;
+        }
+
+        update();
+        return;
+    }
+
+    // Every frame is uploaded to its own texture once, then just switched to
+    if(!img->texture)
+    {
+        glGenTextures(1, &img->texture);
+        RGLState::bindTexture(img->texture);
+
+        // Set texture parameters
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        // Set texture filtering, the mip chain is sampled however it's built
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    // Set texture parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    // Set texture filtering
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        //Create texture, stbi always decodes to RGBA
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, img->w, img->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, img->image);
+        RGLState::countTextureUpload(img->w * img->h * 4);
 
-    //Create texture
-    if(img->comp == 3)
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_width, m_height, 0, GL_RGB, GL_UNSIGNED_BYTE, img->image);
-    else if(img->comp == 4)
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, img->image);
+        if(img->mips != nullptr)
+            RMipmapBuilder::upload(img->mips);
+        else
+            glGenerateMipmap(GL_TEXTURE_2D);
 
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, 0);
+        RMemoryTracker::allocate(MEMORY_TEXTURES, img->texture,
+                                 RMemoryTracker::textureSize(img->w, img->h, 4, true), getID());
+
+        // The texture keeps the pixels now
+        freeFrame(img);
+    }
+    m_texture = img->texture;
+    m_placeholder = false;
 
     update();
 }
 
+/*virtual*/ void RAnimatedPixmap::imageDecoded(unsigned ticket, unsigned char *image, RMipChain *mips,
+                                               int width, int height, int comp)
+{
+    unsigned index = 0;
+    while(index < m_images.size() && m_images[index]->ticket != ticket)
+        index++;
+
+    if(index == m_images.size())
+    {
+        freeFrame(image);
+        RMipmapBuilder::destroy(mips);
+        return;
+    }
+
+    Image *img = m_images[index];
+
+    if(!image)
+    {
+        // Drop the frame, the animation goes on without it
+        m_images.erase(m_images.begin() + index);
+        delete img;
+
+        if(currentFrame > index)
+            currentFrame--;
+        if(currentFrame >= m_images.size())
+            currentFrame = 0;
+
+        if(m_images.empty())
+        {
+            imgLoaded = false;
+            m_texture = 0;
+            m_placeholder = false;
+            markDirty();
+        }
+        else if(m_shown)
+            show();
+
+        return;
+    }
+
+    img->image = image;
+    img->mips = mips;
+    img->w = width;
+    img->h = height;
+    img->comp = comp;
+    img->ticket = 0;
+
+    if(index == currentFrame && m_shown)
+        show();
+}
+
+/*virtual*/ void RAnimatedPixmap::textureUploaded(unsigned ticket, GLuint texture)
+{
+    for(unsigned i = 0; i < m_images.size(); ++i)
+    {
+        if(m_images[i]->upload != ticket)
+            continue;
+
+        m_images[i]->texture = texture;
+        m_images[i]->upload = 0;
+
+        if(i == currentFrame)
+        {
+            m_texture = texture;
+            m_placeholder = false;
+            markDirty();
+        }
+        return;
+    }
+}
+
 void RAnimatedPixmap::fitByImage()
 {
     if(!imgLoaded)
@@ -129,10 +290,32 @@ void RAnimatedPixmap::fitByImage()
 
     m_width = img->w;
     m_height = img->h;
+    m_resized = true;
+}
+
+void RAnimatedPixmap::freeFrame(Image *img)
+{
+    freeFrame(img->image);
+    img->image = nullptr;
+
+    RMipmapBuilder::destroy(img->mips);
+    img->mips = nullptr;
+}
+
+void RAnimatedPixmap::freeFrame(unsigned char *image)
+{
+    if(!image)
+        return;
+
+    RMemoryTracker::release(MEMORY_DECODED_IMAGES, (uintptr_t)image);
+    stbi_image_free(image);
 }
 
 void RAnimatedPixmap::nextFrame()
 {
+    if(m_images.empty())
+        return;
+
     if(currentFrame == m_images.size() - 1)
         currentFrame = 0;
     else
@@ -140,8 +323,12 @@ void RAnimatedPixmap::nextFrame()
 
     Image *img = m_images[currentFrame];
 
-    m_width = img->w;
-    m_height = img->h;
+    // A frame still decoding keeps the current size
+    if(img->w && img->h)
+    {
+        m_width = img->w;
+        m_height = img->h;
+    }
 
     show();
 }
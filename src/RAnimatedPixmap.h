@@ -32,12 +32,22 @@ public:
     ~RAnimatedPixmap();
 
     /**
-     * @brief loads the image into the widget.
+     * @brief loads the image into the widget as the next frame. Files in a
+     * mounted RAssetPack are taken from there, others from the disk.
      * @param const char array.
      * @return True, if file is successfully loaded. False, if not.
      */
     bool loadFile(const char *file);
 
+    /**
+     * @brief starts decoding the next frame asynchronously. Frames keep the
+     * order they are requested in; a frame still decoding is drawn as a placeholder.
+     * @param path to the file and function called when the frame is loaded or failed.
+     * @return future, which is true if the frame is loaded.
+     */
+    std::shared_future<bool> loadFileAsync(const char *file,
+                                           void (*callback)(RPixmap *pixmap, bool loaded) = nullptr);
+
     /**
      * @brief shows the next image to the screen.
      * @param void.
@@ -59,16 +69,46 @@ public:
      */
     void fitByImage();
 
+protected:
+    /**
+     * @brief puts a decoded frame to its place, drops the frame if it failed.
+     * @param ticket of the frame's request, image, its mipmaps and its size.
+     * @return void.
+     */
+    virtual void imageDecoded(unsigned ticket, unsigned char *image, RMipChain *mips,
+                              int width, int height, int comp);
+
+    /**
+     * @brief gives the streamed texture to its frame.
+     * @param ticket of the upload and the complete texture.
+     * @return void.
+     */
+    virtual void textureUploaded(unsigned ticket, GLuint texture);
 
 private:
     struct Image {
         unsigned char *image;
+        // Mipmaps built by RMipmapBuilder, nullptr if the GPU generates them
+        RMipChain *mips;
         int w, h, comp;
         int index;
+        GLuint texture;
+        // Ticket of the unfinished asynchronous load, 0 if there is none
+        unsigned ticket;
+        // Ticket of the unfinished streamed upload, 0 if there is none
+        unsigned upload;
     };
     std::vector<Image*> m_images;
 
     unsigned currentFrame;
+
+    /**
+     * @brief frees the decoded image and its mipmaps, if there are ones.
+     * @param frame or the image itself.
+     * @return void.
+     */
+    void freeFrame(Image *img);
+    void freeFrame(unsigned char *image);
 };
 }
 
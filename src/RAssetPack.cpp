@@ -0,0 +1,553 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RAssetPack.h"
+//C++
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <new>
+//STB
+#include "stb/stb_image.h"
+
+namespace Realio {
+namespace {
+const char MAGIC[4] = {'R', 'P', 'A', 'K'};
+const uint32_t VERSION = 1;
+const uint64_t DATA_ALIGNMENT = 16;
+
+// Limits of the LZ4 block format: matches are at least 4 bytes long and
+// reach 64 KiB back, the last match starts 12 bytes before the end and
+// the last 5 bytes are always literals
+const size_t MIN_MATCH = 4;
+const size_t MAX_OFFSET = 65535;
+const size_t MATCH_LIMIT = 12;
+const size_t LAST_LITERALS = 5;
+const unsigned HASH_BITS = 12;
+// A byte of a block grows into 255 at most, when it extends a length
+const uint64_t MAX_RATIO = 255;
+
+struct PackedFile {
+    std::string name;
+    uint64_t hash;
+    std::vector<unsigned char> data;
+    uint64_t originalSize;
+    uint32_t compression;
+};
+
+uint64_t alignUp(uint64_t offset)
+{
+    return (offset + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+}
+
+// Names don't depend on how the path was spelled relative to the directory
+const char* normalize(const char *path)
+{
+    while(path[0] == '.' && path[1] == '/')
+        path += 2;
+
+    return path;
+}
+
+uint64_t hashName(const char *name, size_t length)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for(size_t i = 0; i < length; ++i)
+    {
+        hash ^= (unsigned char)name[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+bool entryBefore(const RAssetPackEntry &entry, uint64_t hash)
+{
+    return entry.hash < hash;
+}
+
+bool fileBefore(const PackedFile &a, const PackedFile &b)
+{
+    return a.hash < b.hash || (a.hash == b.hash && a.name < b.name);
+}
+
+uint32_t read32(const unsigned char *data)
+{
+    uint32_t value;
+    std::memcpy(&value, data, 4);
+    return value;
+}
+
+void writeLength(std::vector<unsigned char> &block, size_t length)
+{
+    length -= 15;
+    while(length >= 255)
+    {
+        block.push_back(255);
+        length -= 255;
+    }
+    block.push_back(length);
+}
+
+// A sequence is literals followed by a match, the last one has no match
+void writeSequence(std::vector<unsigned char> &block, const unsigned char *literals, size_t literalLength,
+                   size_t offset, size_t matchLength)
+{
+    size_t match = matchLength > 0 ? matchLength - MIN_MATCH : 0;
+    block.push_back((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(match, 15));
+
+    if(literalLength >= 15)
+        writeLength(block, literalLength);
+    block.insert(block.end(), literals, literals + literalLength);
+
+    if(matchLength == 0)
+        return;
+
+    block.push_back(offset & 0xFF);
+    block.push_back(offset >> 8);
+    if(match >= 15)
+        writeLength(block, match);
+}
+
+bool readLength(const unsigned char *block, size_t size, size_t &in, size_t &length)
+{
+    unsigned char byte;
+    do
+    {
+        if(in >= size)
+            return false;
+        byte = block[in++];
+        length += byte;
+    } while(byte == 255);
+
+    return true;
+}
+}
+
+/*static*/ bool RAssetPack::mount(const char *path)
+{
+    Pack *pack = new Pack;
+    pack->path = path;
+    pack->entries = nullptr;
+    pack->count = 0;
+
+    if(!pack->file.open(path))
+    {
+        std::cerr << "Could not open asset pack '" << path << "'" << std::endl;
+        delete pack;
+        return false;
+    }
+
+    const unsigned char *data = pack->file.getData();
+    uint64_t size = pack->file.getSize();
+    const RAssetPackHeader *header = (const RAssetPackHeader*)data;
+
+    bool valid = size >= sizeof(RAssetPackHeader) &&
+                 std::memcmp(header->magic, MAGIC, 4) == 0 && header->version == VERSION &&
+                 header->count <= (size - sizeof(RAssetPackHeader)) / sizeof(RAssetPackEntry);
+
+    if(valid)
+    {
+        pack->entries = (const RAssetPackEntry*)(data + sizeof(RAssetPackHeader));
+        pack->count = header->count;
+    }
+
+    // The index is used in place, so every entry must stay inside the file
+    for(unsigned i = 0; valid && i < pack->count; ++i)
+    {
+        const RAssetPackEntry &entry = pack->entries[i];
+        valid = entry.nameOffset <= size && entry.nameLength <= size - entry.nameOffset &&
+                entry.offset <= size && entry.size <= size - entry.offset &&
+                ((entry.compression == PACK_LZ4 && entry.originalSize / MAX_RATIO <= entry.size) ||
+                 (entry.compression == PACK_STORED && entry.size == entry.originalSize)) &&
+                (i == 0 || pack->entries[i - 1].hash <= entry.hash);
+    }
+
+    if(!valid)
+    {
+        std::cerr << "Could not mount asset pack '" << path << "': bad index" << std::endl;
+        delete pack;
+        return false;
+    }
+
+    packs().push_back(pack);
+    return true;
+}
+
+/*static*/ void RAssetPack::unmount(const char *path)
+{
+    for(unsigned i = 0; i < packs().size(); ++i)
+    {
+        if(packs()[i]->path != path)
+            continue;
+
+        delete packs()[i];
+        packs().erase(packs().begin() + i);
+        return;
+    }
+}
+
+/*static*/ unsigned RAssetPack::getPackCount()
+{
+    return packs().size();
+}
+
+/*static*/ bool RAssetPack::contains(const char *path)
+{
+    Pack *pack = nullptr;
+    return find(path, pack) != nullptr;
+}
+
+/*static*/ const unsigned char* RAssetPack::map(const char *path, size_t &size)
+{
+    Pack *pack = nullptr;
+    const RAssetPackEntry *entry = find(path, pack);
+    if(entry == nullptr || entry->compression != PACK_STORED)
+        return nullptr;
+
+    size = entry->size;
+    return pack->file.getData() + entry->offset;
+}
+
+/*static*/ bool RAssetPack::read(const char *path, std::vector<unsigned char> &data, size_t limit)
+{
+    Pack *pack = nullptr;
+    const RAssetPackEntry *entry = find(path, pack);
+
+    // Loose files are the fallback
+    if(entry == nullptr)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if(!file)
+            return false;
+
+        if(limit == 0)
+            data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        else
+        {
+            data.resize(limit);
+            file.read((char*)data.data(), limit);
+            data.resize(file.gcount());
+        }
+        return true;
+    }
+
+    uint64_t size = entry->originalSize;
+    if(limit > 0)
+        size = std::min<uint64_t>(size, limit);
+
+    // Sizes are bounded by the pack, not by memory, so a large one fails here
+    bool allocated = size <= data.max_size();
+    if(allocated)
+    {
+        try
+        {
+            data.resize(size);
+        }
+        catch(const std::bad_alloc&)
+        {
+            allocated = false;
+        }
+    }
+
+    if(!allocated)
+    {
+        std::cerr << "Could not read '" << path << "' from asset pack '" << pack->path <<
+                     "': out of memory for " << size << " bytes" << std::endl;
+        data.clear();
+        return false;
+    }
+
+    const unsigned char *bytes = pack->file.getData() + entry->offset;
+
+    if(entry->compression == PACK_STORED)
+    {
+        if(size > 0)
+            std::memcpy(data.data(), bytes, size);
+        return true;
+    }
+
+    if(!decompress(bytes, entry->size, data.data(), size))
+    {
+        std::cerr << "Could not read '" << path << "' from asset pack '" << pack->path <<
+                     "': damaged entry" << std::endl;
+        data.clear();
+        return false;
+    }
+
+    return true;
+}
+
+/*static*/ unsigned char* RAssetPack::loadImage(const char *path, int &width, int &height, int &components,
+                                                std::string &error)
+{
+    unsigned char *image = nullptr;
+
+    size_t size = 0;
+    const unsigned char *stored = map(path, size);
+
+    if(stored != nullptr)
+        image = stbi_load_from_memory(stored, size, &width, &height, &components, STBI_rgb_alpha);
+    else if(contains(path))
+    {
+        std::vector<unsigned char> data;
+        if(!read(path, data))
+        {
+            error = "damaged entry in the asset pack";
+            return nullptr;
+        }
+        image = stbi_load_from_memory(data.data(), data.size(), &width, &height, &components, STBI_rgb_alpha);
+    }
+    else
+        image = stbi_load(path, &width, &height, &components, STBI_rgb_alpha);
+
+    if(!image)
+    {
+        // stbi keeps one reason for all threads, so it may be a neighbour's
+        const char *reason = stbi_failure_reason();
+        error = reason != nullptr ? reason : "unknown error";
+    }
+
+    return image;
+}
+
+/*static*/ bool RAssetPack::write(const char *path, const std::vector<std::string> &files, bool compress)
+{
+    std::vector<PackedFile> packed;
+
+    for(unsigned i = 0; i < files.size(); ++i)
+    {
+        PackedFile file;
+        file.name = normalize(files[i].c_str());
+        file.hash = hashName(file.name.c_str(), file.name.size());
+
+        std::ifstream input(files[i].c_str(), std::ios::binary);
+        if(!input)
+        {
+            std::cerr << "Could not read '" << files[i] << "' into asset pack '" << path << "'" << std::endl;
+            return false;
+        }
+        file.data.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+        file.originalSize = file.data.size();
+        file.compression = PACK_STORED;
+
+        // Already compressed formats like PNG rarely shrink, so they stay in place
+        std::vector<unsigned char> block;
+        if(compress && RAssetPack::compress(file.data.data(), file.data.size(), block) < file.data.size())
+        {
+            file.data.swap(block);
+            file.compression = PACK_LZ4;
+        }
+
+        packed.push_back(file);
+    }
+
+    std::sort(packed.begin(), packed.end(), fileBefore);
+
+    for(unsigned i = 1; i < packed.size(); ++i)
+    {
+        if(packed[i].name == packed[i - 1].name)
+        {
+            std::cerr << "Could not write asset pack '" << path << "': '" << packed[i].name <<
+                         "' is given twice" << std::endl;
+            return false;
+        }
+    }
+
+    RAssetPackHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, 4);
+    header.version = VERSION;
+    header.count = packed.size();
+
+    std::vector<RAssetPackEntry> entries(packed.size());
+    std::string names;
+
+    uint64_t nameOffset = sizeof(header) + entries.size() * sizeof(RAssetPackEntry);
+    for(unsigned i = 0; i < packed.size(); ++i)
+    {
+        std::memset(&entries[i], 0, sizeof(RAssetPackEntry));
+        entries[i].hash = packed[i].hash;
+        entries[i].size = packed[i].data.size();
+        entries[i].originalSize = packed[i].originalSize;
+        entries[i].nameOffset = nameOffset + names.size();
+        entries[i].nameLength = packed[i].name.size();
+        entries[i].compression = packed[i].compression;
+        names += packed[i].name;
+    }
+
+    uint64_t offset = alignUp(nameOffset + names.size());
+    for(unsigned i = 0; i < packed.size(); ++i)
+    {
+        entries[i].offset = offset;
+        offset = alignUp(offset + entries[i].size);
+    }
+
+    std::ofstream output(path, std::ios::binary);
+    if(!output)
+    {
+        std::cerr << "Could not write asset pack '" << path << "'" << std::endl;
+        return false;
+    }
+
+    output.write((const char*)&header, sizeof(header));
+    output.write((const char*)entries.data(), entries.size() * sizeof(RAssetPackEntry));
+    output.write(names.data(), names.size());
+
+    for(unsigned i = 0; i < packed.size(); ++i)
+    {
+        // Pad up to the entry's offset
+        std::vector<char> padding(entries[i].offset - output.tellp(), 0);
+        output.write(padding.data(), padding.size());
+        output.write((const char*)packed[i].data.data(), packed[i].data.size());
+    }
+
+    return (bool)output;
+}
+
+/*static*/ size_t RAssetPack::compress(const unsigned char *data, size_t size, std::vector<unsigned char> &block)
+{
+    block.clear();
+    block.reserve(size + size / 255 + 16);
+
+    // Last position of every hashed 4 byte sequence
+    std::vector<size_t> table(1 << HASH_BITS, 0);
+    size_t anchor = 0, pos = 0;
+
+    while(size > MATCH_LIMIT && pos < size - MATCH_LIMIT)
+    {
+        uint32_t sequence = read32(data + pos);
+        uint32_t hash = (sequence * 2654435761U) >> (32 - HASH_BITS);
+        size_t candidate = table[hash];
+        table[hash] = pos;
+
+        if(candidate >= pos || pos - candidate > MAX_OFFSET || read32(data + candidate) != sequence)
+        {
+            pos++;
+            continue;
+        }
+
+        // Grow the match back over the pending literals, then forward
+        while(pos > anchor && candidate > 0 && data[pos - 1] == data[candidate - 1])
+        {
+            pos--;
+            candidate--;
+        }
+
+        size_t length = MIN_MATCH;
+        while(pos + length < size - LAST_LITERALS && data[pos + length] == data[candidate + length])
+            length++;
+
+        writeSequence(block, data + anchor, pos - anchor, pos - candidate, length);
+
+        pos += length;
+        anchor = pos;
+    }
+
+    writeSequence(block, data + anchor, size - anchor, 0, 0);
+    return block.size();
+}
+
+/*static*/ bool RAssetPack::decompress(const unsigned char *block, size_t size, unsigned char *data, size_t capacity)
+{
+    if(capacity == 0)
+        return true;
+
+    size_t in = 0, out = 0;
+
+    while(in < size)
+    {
+        unsigned char token = block[in++];
+
+        size_t literals = token >> 4;
+        if(literals == 15 && !readLength(block, size, in, literals))
+            return false;
+        if(literals > size - in)
+            return false;
+
+        size_t copy = std::min(literals, capacity - out);
+        std::memcpy(data + out, block + in, copy);
+        in += literals;
+        out += copy;
+
+        if(out == capacity)
+            return true;
+        // The last sequence has no match
+        if(in == size)
+            break;
+
+        if(size - in < 2)
+            return false;
+        size_t offset = block[in] | (block[in + 1] << 8);
+        in += 2;
+        if(offset == 0 || offset > out)
+            return false;
+
+        size_t length = token & 15;
+        if(length == 15 && !readLength(block, size, in, length))
+            return false;
+        length = std::min(length + MIN_MATCH, capacity - out);
+
+        // Matches may overlap their own output, so bytes go one by one
+        for(size_t i = 0; i < length; ++i)
+            data[out + i] = data[out - offset + i];
+        out += length;
+
+        if(out == capacity)
+            return true;
+    }
+
+    return out == capacity;
+}
+
+/*static*/ const RAssetPackEntry* RAssetPack::find(const char *path, Pack *&pack)
+{
+    if(packs().empty())
+        return nullptr;
+
+    const char *name = normalize(path);
+    size_t length = std::strlen(name);
+    uint64_t hash = hashName(name, length);
+
+    for(unsigned i = packs().size(); i-- > 0;)
+    {
+        Pack *candidate = packs()[i];
+        const RAssetPackEntry *end = candidate->entries + candidate->count;
+        const RAssetPackEntry *entry = std::lower_bound(candidate->entries, end, hash, entryBefore);
+
+        for(; entry != end && entry->hash == hash; ++entry)
+        {
+            if(entry->nameLength == length &&
+               std::memcmp(candidate->file.getData() + entry->nameOffset, name, length) == 0)
+            {
+                pack = candidate;
+                return entry;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+/*static*/ std::vector<RAssetPack::Pack*>& RAssetPack::packs()
+{
+    static std::vector<Pack*> mounted;
+    return mounted;
+}
+}
@@ -0,0 +1,165 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RASSETPACK_H
+#define RASSETPACK_H
+
+//Realio
+#include "RMappedFile.h"
+//C++
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Realio {
+//Compression of pack entries
+typedef enum
+{
+    PACK_STORED = 0,                          //Raw bytes, used in place
+    PACK_LZ4 = 1                              //One LZ4 block
+} RPackCompression;
+
+// Laid out as stored, little endian. The entries follow the header sorted
+// by hash, then their names and their data at 16 byte aligned offsets.
+struct RAssetPackHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+struct RAssetPackEntry
+{
+    // FNV-1a of the name
+    uint64_t hash;
+    uint64_t offset;
+    // Bytes in the pack and after decompression
+    uint64_t size;
+    uint64_t originalSize;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t compression;
+    uint32_t reserved;
+};
+
+class RAssetPack
+{
+public:
+    /**
+     * @brief maps the pack and makes its files visible to every loader.
+     * Files of packs mounted later hide the same files of earlier ones.
+     * Mount packs before loading starts, the loader's threads read them unlocked.
+     * @param path to the pack.
+     * @return true, if the pack is mounted. false, if it can't be opened or is damaged.
+     */
+    static bool mount(const char *path);
+
+    /**
+     * @brief unmounts the pack. Texture files taken from it must be closed first.
+     * @param path to the pack as it was mounted.
+     * @return void.
+     */
+    static void unmount(const char *path);
+
+    /**
+     * @brief returns number of mounted packs.
+     * @param void.
+     * @return number of packs.
+     */
+    static unsigned getPackCount();
+
+    /**
+     * @brief returns true, if a mounted pack has the file.
+     * @param path to the file.
+     * @return true, if it's packed. false, if it's a loose file or missing.
+     */
+    static bool contains(const char *path);
+
+    /**
+     * @brief returns a packed file, which is stored uncompressed, in place.
+     * @param path to the file and place for its size.
+     * @return pointer into the pack, nullptr if the file isn't packed or is compressed.
+     */
+    static const unsigned char* map(const char *path, size_t &size);
+
+    /**
+     * @brief reads the file from a mounted pack or, if it isn't packed, from the disk.
+     * Packed entries are independent, so threads may read them at once.
+     * @param path to the file, place for its bytes and number of bytes to read, 0 for all.
+     * @return true, if the file is read. false, if not.
+     */
+    static bool read(const char *path, std::vector<unsigned char> &data, size_t limit = 0);
+
+    /**
+     * @brief decodes an image from a mounted pack or, if it isn't packed, from the disk.
+     * The image is always RGBA and is freed with stbi_image_free().
+     * @param path to the file, places for the image's size, its components in the file and the error.
+     * @return decoded image, nullptr if it can't be loaded.
+     */
+    static unsigned char* loadImage(const char *path, int &width, int &height, int &components,
+                                    std::string &error);
+
+    /**
+     * @brief writes the files into a pack. Names are the paths as given,
+     * without a leading "./", so the pack is meant to be mounted from the
+     * directory the files are loaded relative to.
+     * @param path to the pack, files and true to compress, where it pays off.
+     * @return true, if the pack is written. false, if not.
+     */
+    static bool write(const char *path, const std::vector<std::string> &files, bool compress);
+
+    /**
+     * @brief compresses bytes into one LZ4 block.
+     * @param bytes, their number and place for the block.
+     * @return size of the block.
+     */
+    static size_t compress(const unsigned char *data, size_t size, std::vector<unsigned char> &block);
+
+    /**
+     * @brief decompresses an LZ4 block, stopping when the result is full,
+     * so a prefix is cheap.
+     * @param block, its size, place for the result and its size.
+     * @return true, if the result is filled. false, if the block is damaged or short.
+     */
+    static bool decompress(const unsigned char *block, size_t size, unsigned char *data, size_t capacity);
+
+private:
+    struct Pack {
+        std::string path;
+        RMappedFile file;
+        const RAssetPackEntry *entries;
+        unsigned count;
+    };
+
+    /**
+     * @brief looks the file up in the mounted packs, the latest first.
+     * @param path to the file and place for its pack.
+     * @return entry of the file, nullptr if it isn't packed.
+     */
+    static const RAssetPackEntry* find(const char *path, Pack *&pack);
+
+    /**
+     * @brief returns the mounted packs. They are created on first use like RShaderCache's entries.
+     * @param void.
+     * @return reference to the packs in mounting order.
+     */
+    static std::vector<Pack*>& packs();
+};
+}
+
+#endif // RASSETPACK_H
@@ -25,6 +25,7 @@ RCamera::RCamera(glm::vec3 position, glm::vec3 up, float yaw, float pitch)
     ,m_movementSpeed(SPEED)
     ,m_mouseSensitivity(SENSITIVITY)
     ,m_zoom(ZOOM)
+    ,m_projectionType(PERSPECTIVE)
 {
     m_position = position;
     m_worldUp = up;
@@ -44,6 +45,28 @@ glm::mat4 RCamera::getViewMatrix()
     return glm::lookAt(m_position, this->m_position + this->m_front, this->m_up);
 }
 
+glm::mat4 RCamera::getProjectionMatrix(float aspect)
+{
+    if(m_projectionType == ORTHOGONAL)
+    {
+        // Zooming out widens the view the same way as a wider field of view
+        float extent = m_zoom / ZOOM;
+        return glm::ortho(-extent, extent, -extent, extent, -100.0f, 100.0f);
+    }
+
+    return glm::perspective(glm::radians(m_zoom), aspect, 0.1f, 100.0f);
+}
+
+void RCamera::setProjectionType(RCameraProjectionType type)
+{
+    m_projectionType = type;
+}
+
+RCameraProjectionType RCamera::getProjectionType()
+{
+    return m_projectionType;
+}
+
 void RCamera::reset()
 {
     m_front = glm::vec3(0.0f, 0.0f, -1.0f);
@@ -61,6 +61,28 @@ public:
      */
     glm::mat4 getViewMatrix();
 
+    /**
+     * @brief returns current projection matrix. Orthogonal projection keeps
+     * the window's coordinates, so the aspect ratio only affects perspective.
+     * @param width of the viewport divided by its height.
+     * @return current projection matrix 4x4.
+     */
+    glm::mat4 getProjectionMatrix(float aspect);
+
+    /**
+     * @brief sets type of the camera's projection.
+     * @param ORTHOGONAL or PERSPECTIVE.
+     * @return void.
+     */
+    void setProjectionType(RCameraProjectionType type);
+
+    /**
+     * @brief returns type of the camera's projection.
+     * @param void.
+     * @return ORTHOGONAL or PERSPECTIVE.
+     */
+    RCameraProjectionType getProjectionType();
+
     /**
      * @brief resets camera's attributes.
      * @param void.
@@ -128,6 +150,7 @@ private:
     float m_movementSpeed;
     float m_mouseSensitivity;
     float m_zoom;
+    RCameraProjectionType m_projectionType;
 
     /**
      * @brief updates all the camera vectors.
@@ -0,0 +1,85 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RCameraBuffer.h"
+#include "RGLState.h"
+#include "RMemoryTracker.h"
+
+namespace Realio {
+const char *RCameraBuffer::BLOCK_NAME = "Camera";
+GLuint RCameraBuffer::m_boundBuffer = 0;
+
+RCameraBuffer::RCameraBuffer()
+{
+    m_uploaded = false;
+
+    glGenBuffers(1, &UBO);
+
+    // Binding the base also binds the generic target, keep RGLState in sync
+    RGLState::bindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), NULL, GL_DYNAMIC_DRAW);
+    RMemoryTracker::allocate(MEMORY_BUFFERS, UBO, sizeof(Block));
+    glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, UBO);
+    m_boundBuffer = UBO;
+}
+
+RCameraBuffer::~RCameraBuffer()
+{
+    if(m_boundBuffer == UBO)
+        m_boundBuffer = 0;
+    RGLState::deleteBuffer(UBO);
+}
+
+void RCameraBuffer::update(RCamera *camera, float aspect)
+{
+    Block block;
+
+    if(camera != nullptr)
+    {
+        block.view = camera->getViewMatrix();
+        block.projection = camera->getProjectionMatrix(aspect);
+    }
+    block.viewProjection = block.projection * block.view;
+
+    if(m_uploaded &&
+       block.view == m_block.view &&
+       block.projection == m_block.projection)
+        return;
+
+    m_block = block;
+    m_uploaded = true;
+
+    RGLState::bindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &m_block);
+    RGLState::countBufferUpload(sizeof(Block));
+}
+
+void RCameraBuffer::bind()
+{
+    if(m_boundBuffer == UBO)
+        return;
+
+    RGLState::bindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, UBO);
+    m_boundBuffer = UBO;
+}
+
+glm::mat4 RCameraBuffer::getViewProjection()
+{
+    return m_block.viewProjection;
+}
+}
@@ -0,0 +1,78 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RCAMERABUFFER_H
+#define RCAMERABUFFER_H
+
+//Realio
+#include "RCamera.h"
+//GLEW
+#include <GL/glew.h>
+//GLM
+#include <glm/glm.hpp>
+
+namespace Realio {
+class RCameraBuffer
+{
+public:
+    RCameraBuffer();
+    ~RCameraBuffer();
+
+    /**
+     * @brief fills the buffer from the camera. Nothing is uploaded, if the
+     * matrices haven't changed since the last frame.
+     * @param camera (nullptr for identity matrices) and the window's aspect ratio.
+     * @return void.
+     */
+    void update(RCamera *camera, float aspect);
+
+    /**
+     * @brief makes programs read the matrices from this buffer. Nothing is
+     * uploaded, so a window can switch between buffers within a frame.
+     * @param void.
+     * @return void.
+     */
+    void bind();
+
+    /**
+     * @brief returns the current projection * view matrix.
+     * @param void.
+     * @return 4x4 matrix from GLM.
+     */
+    glm::mat4 getViewProjection();
+
+    // Binding point of the "Camera" uniform block in every program
+    static const GLuint BINDING = 0;
+    // Name of the uniform block
+    static const char *BLOCK_NAME;
+
+private:
+    // std140 layout of the block: three column-major mat4
+    struct Block {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::mat4 viewProjection;
+    };
+    Block m_block;
+    bool m_uploaded;
+
+    GLuint UBO;
+    // Buffer at the binding point, so binding it again is skipped
+    static GLuint m_boundBuffer;
+};
+}
+
+#endif // RCAMERABUFFER_H
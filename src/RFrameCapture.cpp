@@ -0,0 +1,346 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RFrameCapture.h"
+#include "RGLState.h"
+#include "RMemoryTracker.h"
+//C++
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace Realio {
+namespace {
+unsigned long crc32(const unsigned char *data, size_t size, unsigned long crc)
+{
+    static unsigned long table[256];
+    static bool initialized = false;
+
+    if(!initialized)
+    {
+        for(unsigned long i = 0; i < 256; ++i)
+        {
+            unsigned long c = i;
+            for(unsigned j = 0; j < 8; ++j)
+                c = c & 1 ? 0xEDB88320UL ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        initialized = true;
+    }
+
+    crc ^= 0xFFFFFFFFUL;
+    for(size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFUL;
+}
+
+void putBigEndian(std::vector<unsigned char> &out, unsigned long value)
+{
+    out.push_back((value >> 24) & 0xFF);
+    out.push_back((value >> 16) & 0xFF);
+    out.push_back((value >> 8) & 0xFF);
+    out.push_back(value & 0xFF);
+}
+
+void putChunk(std::vector<unsigned char> &out, const char *type, const std::vector<unsigned char> &data)
+{
+    putBigEndian(out, data.size());
+
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+
+    putBigEndian(out, crc32(out.data() + start, out.size() - start, 0));
+}
+
+/**
+ * @brief encodes the frame as an RGBA PNG with stored deflate blocks.
+ * Frames are written to be diffed or converted later, so speed wins over size.
+ * @param frame and place for the file's bytes.
+ * @return void.
+ */
+void encodePng(const RCapturedFrame &frame, std::vector<unsigned char> &out)
+{
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    out.assign(signature, signature + 8);
+
+    std::vector<unsigned char> header;
+    putBigEndian(header, frame.width);
+    putBigEndian(header, frame.height);
+    header.push_back(8); // Bits per channel
+    header.push_back(6); // RGBA
+    header.push_back(0); // Deflate
+    header.push_back(0); // Adaptive filtering
+    header.push_back(0); // No interlace
+    putChunk(out, "IHDR", header);
+
+    // Every row starts with its filter, 0 is none
+    size_t stride = frame.width * 4;
+    std::vector<unsigned char> raw;
+    raw.reserve((stride + 1) * frame.height);
+    for(int y = 0; y < frame.height; ++y)
+    {
+        raw.push_back(0);
+        raw.insert(raw.end(), frame.pixels.begin() + y * stride, frame.pixels.begin() + (y + 1) * stride);
+    }
+
+    std::vector<unsigned char> data;
+    data.push_back(0x78); // zlib header without compression
+    data.push_back(0x01);
+
+    unsigned long a = 1, b = 0;
+    for(size_t offset = 0; offset < raw.size() || offset == 0; )
+    {
+        size_t size = std::min<size_t>(raw.size() - offset, 65535);
+        bool last = offset + size >= raw.size();
+
+        data.push_back(last ? 1 : 0);
+        data.push_back(size & 0xFF);
+        data.push_back((size >> 8) & 0xFF);
+        data.push_back(~size & 0xFF);
+        data.push_back((~size >> 8) & 0xFF);
+        data.insert(data.end(), raw.begin() + offset, raw.begin() + offset + size);
+
+        for(size_t i = offset; i < offset + size; ++i)
+        {
+            a = (a + raw[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+
+        offset += size;
+        if(last)
+            break;
+    }
+    putBigEndian(data, (b << 16) | a);
+    putChunk(out, "IDAT", data);
+
+    putChunk(out, "IEND", std::vector<unsigned char>());
+}
+}
+
+RFrameCapture::RFrameCapture(const int width, const int height, const unsigned slots)
+{
+    m_width = width;
+    m_height = height;
+    m_next = m_oldest = m_pending = 0;
+    m_frames = 0;
+    m_dropped = 0;
+    m_format = CAPTURE_PNG;
+    m_writing = false;
+
+    callback = nullptr;
+
+    m_slots.resize(slots > 0 ? slots : 1);
+    for(unsigned i = 0; i < m_slots.size(); ++i)
+    {
+        glGenBuffers(1, &m_slots[i].buffer);
+        RGLState::bindBuffer(GL_PIXEL_PACK_BUFFER, m_slots[i].buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, m_width * m_height * 4, NULL, GL_STREAM_READ);
+        RMemoryTracker::allocate(MEMORY_BUFFERS, m_slots[i].buffer, m_width * m_height * 4);
+
+        m_slots[i].fence = (GLsync)0;
+        m_slots[i].index = 0;
+    }
+    RGLState::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+RFrameCapture::~RFrameCapture()
+{
+    collect(true);
+    stopWriter();
+
+    for(unsigned i = 0; i < m_slots.size(); ++i)
+    {
+        if(m_slots[i].fence)
+            glDeleteSync(m_slots[i].fence);
+        RGLState::deleteBuffer(m_slots[i].buffer);
+    }
+}
+
+void RFrameCapture::setCallback(void (*func)(const RCapturedFrame &frame))
+{
+    callback = func;
+}
+
+bool RFrameCapture::startWriter(const std::string &prefix, RCaptureFormat format)
+{
+    if(m_writing)
+        return false;
+
+    m_prefix = prefix;
+    m_format = format;
+    m_writing = true;
+    m_writer = std::thread(&RFrameCapture::writerLoop, this);
+
+    return true;
+}
+
+void RFrameCapture::stopWriter()
+{
+    if(!m_writing)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_writing = false;
+    }
+    m_condition.notify_one();
+    m_writer.join();
+}
+
+void RFrameCapture::capture(GLuint framebuffer)
+{
+    Slot &slot = m_slots[m_next];
+
+    // Waiting for the oldest frame would stall the pipeline
+    if(m_pending == m_slots.size())
+    {
+        m_dropped++;
+        m_frames++;
+        return;
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glReadBuffer(framebuffer ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+
+    // The copy happens on the GPU, glReadPixels returns at once
+    RGLState::bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    RGLState::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.index = m_frames++;
+
+    m_next = (m_next + 1) % m_slots.size();
+    m_pending++;
+}
+
+void RFrameCapture::collect(bool wait)
+{
+    while(m_pending > 0)
+    {
+        Slot &slot = m_slots[m_oldest];
+
+        GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                         wait ? GL_TIMEOUT_IGNORED : 0);
+        if(status == GL_TIMEOUT_EXPIRED)
+            return;
+
+        deliver();
+    }
+}
+
+void RFrameCapture::deliver()
+{
+    Slot &slot = m_slots[m_oldest];
+
+    RCapturedFrame *frame = new RCapturedFrame;
+    frame->index = slot.index;
+    frame->width = m_width;
+    frame->height = m_height;
+    frame->pixels.resize(m_width * m_height * 4);
+
+    RGLState::bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const unsigned char *memory = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                                                                       frame->pixels.size(), GL_MAP_READ_BIT);
+    if(memory != nullptr)
+    {
+        // GL reads rows from the bottom
+        size_t stride = m_width * 4;
+        for(int y = 0; y < m_height; ++y)
+            std::memcpy(frame->pixels.data() + y * stride, memory + (m_height - 1 - y) * stride, stride);
+
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    else
+        std::cerr << "Could not map captured frame " << slot.index << std::endl;
+    RGLState::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    glDeleteSync(slot.fence);
+    slot.fence = (GLsync)0;
+    m_oldest = (m_oldest + 1) % m_slots.size();
+    m_pending--;
+
+    if(memory == nullptr)
+    {
+        delete frame;
+        return;
+    }
+
+    if(callback != nullptr)
+        callback(*frame);
+
+    if(m_writing)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.push_back(frame);
+        }
+        m_condition.notify_one();
+    }
+    else
+        delete frame;
+}
+
+unsigned RFrameCapture::getDroppedFrames()
+{
+    return m_dropped;
+}
+
+void RFrameCapture::writerLoop()
+{
+    std::vector<unsigned char> encoded;
+
+    while(true)
+    {
+        RCapturedFrame *frame;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while(m_writing && m_queue.empty())
+                m_condition.wait(lock);
+
+            // Queued frames are written before stopping
+            if(m_queue.empty())
+                return;
+
+            frame = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        char name[16];
+        std::snprintf(name, sizeof(name), "%06u", frame->index);
+        std::string path = m_prefix + name + (m_format == CAPTURE_PNG ? ".png" : ".rgba");
+
+        std::ofstream file(path.c_str(), std::ios::binary);
+        if(!file)
+            std::cerr << "Could not write captured frame to '" << path << "'" << std::endl;
+        else if(m_format == CAPTURE_PNG)
+        {
+            encodePng(*frame, encoded);
+            file.write((const char*)encoded.data(), encoded.size());
+        }
+        else
+            file.write((const char*)frame->pixels.data(), frame->pixels.size());
+
+        delete frame;
+    }
+}
+}
@@ -0,0 +1,142 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RFRAMECAPTURE_H
+#define RFRAMECAPTURE_H
+
+//C++
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+//GLEW
+#include <GL/glew.h>
+
+namespace Realio {
+//Formats of the written frames
+typedef enum
+{
+    CAPTURE_RAW,                              //RGBA bytes, rows from the top
+    CAPTURE_PNG                               //Uncompressed PNG
+} RCaptureFormat;
+
+struct RCapturedFrame
+{
+    unsigned index;
+    int width, height;
+    // RGBA pixels, rows from the top
+    std::vector<unsigned char> pixels;
+};
+
+class RFrameCapture
+{
+public:
+    /**
+     * @brief creates a ring of pixel buffers. Frames are read into them
+     * asynchronously and delivered when the GPU is done with them.
+     * @param size of the captured frames and number of buffers.
+     */
+    RFrameCapture(const int width, const int height, const unsigned slots = 3);
+    ~RFrameCapture();
+
+    /**
+     * @brief sets function called with every captured frame on the rendering thread.
+     * @param pointer to a function, nullptr to call nothing.
+     * @return void.
+     */
+    void setCallback(void (*func)(const RCapturedFrame &frame));
+
+    /**
+     * @brief starts a thread, which writes captured frames to files
+     * named prefix000000.png (or .rgba for raw frames).
+     * @param prefix of the files' paths and format.
+     * @return true, if the thread is started. false, if it is already running.
+     */
+    bool startWriter(const std::string &prefix, RCaptureFormat format);
+
+    /**
+     * @brief writes queued frames and stops the writer thread.
+     * @param void.
+     * @return void.
+     */
+    void stopWriter();
+
+    /**
+     * @brief starts reading the framebuffer into the next free buffer.
+     * The frame is dropped, if no buffer is free.
+     * @param framebuffer, 0 for the window's back buffer.
+     * @return void.
+     */
+    void capture(GLuint framebuffer);
+
+    /**
+     * @brief delivers frames, which are already read, in order.
+     * @param true to wait for all pending frames.
+     * @return void.
+     */
+    void collect(bool wait = false);
+
+    /**
+     * @brief returns number of frames dropped since the capture was created.
+     * @param void.
+     * @return number of frames.
+     */
+    unsigned getDroppedFrames();
+
+private:
+    struct Slot {
+        GLuint buffer;
+        GLsync fence;
+        unsigned index;
+    };
+    std::vector<Slot> m_slots;
+    // Slot to read the next frame into and the oldest pending one
+    unsigned m_next, m_oldest;
+    unsigned m_pending;
+
+    int m_width, m_height;
+    unsigned m_frames;
+    unsigned m_dropped;
+
+    void (*callback)(const RCapturedFrame &frame);
+
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<RCapturedFrame*> m_queue;
+    std::string m_prefix;
+    RCaptureFormat m_format;
+    bool m_writing;
+
+    /**
+     * @brief copies the oldest pending frame out of its buffer and delivers it.
+     * @param void.
+     * @return void.
+     */
+    void deliver();
+
+    /**
+     * @brief writes queued frames until the writer is stopped.
+     * @param void.
+     * @return void.
+     */
+    void writerLoop();
+};
+}
+
+#endif // RFRAMECAPTURE_H
@@ -0,0 +1,122 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RFrameStats.h"
+//C++
+#include <algorithm>
+#include <cstring>
+
+namespace Realio {
+namespace {
+double percentile(const std::vector<double> &sorted, double fraction)
+{
+    size_t index = std::min(sorted.size() - 1, (size_t)(fraction * sorted.size()));
+    return sorted[index];
+}
+}
+
+RFrameHistory::RFrameHistory(const unsigned size)
+{
+    m_size = size > 0 ? size : 1;
+    m_next = 0;
+    m_samples.reserve(m_size);
+}
+
+void RFrameHistory::push(const RFrameSample &sample)
+{
+    if(m_samples.size() < m_size)
+        m_samples.push_back(sample);
+    else
+        m_samples[m_next] = sample;
+
+    m_next = (m_next + 1) % m_size;
+}
+
+void RFrameHistory::setSize(const unsigned size)
+{
+    m_size = size > 0 ? size : 1;
+    m_next = 0;
+    m_samples.clear();
+    m_samples.reserve(m_size);
+}
+
+RFrameStats RFrameHistory::getStats()
+{
+    RFrameStats stats;
+    std::memset(&stats, 0, sizeof(stats));
+
+    if(m_samples.empty())
+        return stats;
+
+    stats.last = m_samples[(m_next + m_size - 1) % m_size];
+    stats.frames = m_samples.size();
+
+    std::vector<double> times;
+    times.reserve(m_samples.size());
+
+    double cpuTime = 0.0;
+    double events = 0.0, widgets = 0.0, drawCalls = 0.0;
+    double programBinds = 0.0, textureBinds = 0.0, vertexArrayBinds = 0.0;
+    double triangles = 0.0, bufferBytes = 0.0, textureBytes = 0.0;
+
+    for(unsigned i = 0; i < m_samples.size(); ++i)
+    {
+        const RFrameSample &sample = m_samples[i];
+
+        cpuTime += sample.cpuTime;
+        events += sample.events;
+        widgets += sample.widgetsUpdated;
+        drawCalls += sample.drawCalls;
+        programBinds += sample.programBinds;
+        textureBinds += sample.textureBinds;
+        vertexArrayBinds += sample.vertexArrayBinds;
+        triangles += sample.triangles;
+        bufferBytes += sample.bufferBytes;
+        textureBytes += sample.textureBytes;
+
+        if(sample.skipped)
+            stats.skippedFrames++;
+
+        unsigned bucket = 0;
+        while(bucket < FRAME_HISTOGRAM_BUCKETS - 1 && sample.cpuTime >= FRAME_HISTOGRAM_BOUNDS[bucket])
+            bucket++;
+        stats.histogram[bucket]++;
+
+        times.push_back(sample.cpuTime);
+    }
+
+    double count = m_samples.size();
+    stats.average.cpuTime = cpuTime / count;
+    stats.average.events = events / count + 0.5;
+    stats.average.widgetsUpdated = widgets / count + 0.5;
+    stats.average.drawCalls = drawCalls / count + 0.5;
+    stats.average.programBinds = programBinds / count + 0.5;
+    stats.average.textureBinds = textureBinds / count + 0.5;
+    stats.average.vertexArrayBinds = vertexArrayBinds / count + 0.5;
+    stats.average.triangles = triangles / count + 0.5;
+    stats.average.bufferBytes = bufferBytes / count + 0.5;
+    stats.average.textureBytes = textureBytes / count + 0.5;
+
+    std::sort(times.begin(), times.end());
+    stats.p50 = percentile(times, 0.50);
+    stats.p95 = percentile(times, 0.95);
+    stats.p99 = percentile(times, 0.99);
+    stats.max = times.back();
+
+    return stats;
+}
+}
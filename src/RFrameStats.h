@@ -0,0 +1,95 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RFRAMESTATS_H
+#define RFRAMESTATS_H
+
+//C++
+#include <vector>
+
+namespace Realio {
+//Work and time of one frame
+struct RFrameSample
+{
+    // Milliseconds from the start of RWindow::update() to its end
+    double cpuTime;
+    unsigned events;
+    unsigned widgetsUpdated;
+    unsigned drawCalls;
+    unsigned programBinds;
+    unsigned textureBinds;
+    unsigned vertexArrayBinds;
+    unsigned long triangles;
+    unsigned long bufferBytes;
+    unsigned long textureBytes;
+    // True, if nothing had changed and the frame wasn't drawn
+    bool skipped;
+};
+
+// Upper bounds of the histogram's buckets in milliseconds, the last bucket has none
+const unsigned FRAME_HISTOGRAM_BUCKETS = 12;
+const double FRAME_HISTOGRAM_BOUNDS[FRAME_HISTOGRAM_BUCKETS - 1] = {
+    1.0, 2.0, 4.0, 8.0, 12.0, 16.7, 20.0, 25.0, 33.4, 50.0, 100.0
+};
+
+struct RFrameStats
+{
+    RFrameSample last;
+
+    // Averages over the rolling window
+    RFrameSample average;
+    unsigned frames;
+    unsigned skippedFrames;
+
+    // CPU frame times over the rolling window in milliseconds
+    double p50, p95, p99, max;
+    unsigned histogram[FRAME_HISTOGRAM_BUCKETS];
+};
+
+class RFrameHistory
+{
+public:
+    explicit RFrameHistory(const unsigned size = 120);
+
+    /**
+     * @brief adds a frame, dropping the oldest one if the window is full.
+     * @param the frame's sample.
+     * @return void.
+     */
+    void push(const RFrameSample &sample);
+
+    /**
+     * @brief sets number of frames in the rolling window and forgets the old ones.
+     * @param number of frames.
+     * @return void.
+     */
+    void setSize(const unsigned size);
+
+    /**
+     * @brief returns statistics of the last frame and the rolling window.
+     * @param void.
+     * @return RFrameStats structure.
+     */
+    RFrameStats getStats();
+
+private:
+    std::vector<RFrameSample> m_samples;
+    unsigned m_size;
+    unsigned m_next;
+};
+}
+
+#endif // RFRAMESTATS_H
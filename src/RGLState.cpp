@@ -0,0 +1,252 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RGLState.h"
+#include "RMemoryTracker.h"
+
+namespace Realio {
+namespace {
+// Value of a binding nobody knows
+const GLuint UNKNOWN = ~0u;
+}
+
+GLuint RGLState::m_program = UNKNOWN;
+unsigned RGLState::m_activeUnit = UNKNOWN;
+GLuint RGLState::m_textures[RGLState::MAX_TEXTURE_UNITS];
+GLuint RGLState::m_vertexArray = UNKNOWN;
+GLuint RGLState::m_buffers[RGLState::BUFFER_TARGETS];
+int RGLState::m_blending = -1;
+GLenum RGLState::m_blendSrc = UNKNOWN;
+GLenum RGLState::m_blendDst = UNKNOWN;
+unsigned RGLState::m_issued = 0;
+unsigned RGLState::m_skipped = 0;
+unsigned RGLState::m_lastIssued = 0;
+unsigned RGLState::m_lastSkipped = 0;
+RGLCounters RGLState::m_counters = RGLCounters();
+
+/*static*/ void RGLState::invalidate()
+{
+    m_program = UNKNOWN;
+    m_activeUnit = UNKNOWN;
+    m_vertexArray = UNKNOWN;
+    m_blending = -1;
+    m_blendSrc = m_blendDst = UNKNOWN;
+
+    for(unsigned i = 0; i < MAX_TEXTURE_UNITS; ++i)
+        m_textures[i] = UNKNOWN;
+    for(unsigned i = 0; i < BUFFER_TARGETS; ++i)
+        m_buffers[i] = UNKNOWN;
+}
+
+/*static*/ void RGLState::beginFrame()
+{
+    m_lastIssued = m_issued;
+    m_lastSkipped = m_skipped;
+    m_issued = m_skipped = 0;
+    m_counters = RGLCounters();
+}
+
+/*static*/ void RGLState::useProgram(GLuint program)
+{
+    if(m_program == program)
+    {
+        m_skipped++;
+        return;
+    }
+
+    glUseProgram(program);
+    m_program = program;
+    m_issued++;
+    m_counters.programBinds++;
+}
+
+/*static*/ void RGLState::activeTexture(unsigned unit)
+{
+    if(m_activeUnit == unit)
+    {
+        m_skipped++;
+        return;
+    }
+
+    glActiveTexture(GL_TEXTURE0 + unit);
+    m_activeUnit = unit;
+    m_issued++;
+}
+
+/*static*/ void RGLState::bindTexture(GLuint texture, unsigned unit)
+{
+    if(unit < MAX_TEXTURE_UNITS && m_textures[unit] == texture)
+    {
+        m_skipped++;
+        return;
+    }
+
+    activeTexture(unit);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    if(unit < MAX_TEXTURE_UNITS)
+        m_textures[unit] = texture;
+    m_issued++;
+    m_counters.textureBinds++;
+}
+
+/*static*/ void RGLState::bindVertexArray(GLuint vao)
+{
+    if(m_vertexArray == vao)
+    {
+        m_skipped++;
+        return;
+    }
+
+    glBindVertexArray(vao);
+    m_vertexArray = vao;
+    m_issued++;
+    m_counters.vertexArrayBinds++;
+}
+
+/*static*/ void RGLState::bindBuffer(GLenum target, GLuint buffer)
+{
+    unsigned slot = bufferSlot(target);
+
+    if(slot < BUFFER_TARGETS && m_buffers[slot] == buffer)
+    {
+        m_skipped++;
+        return;
+    }
+
+    glBindBuffer(target, buffer);
+    if(slot < BUFFER_TARGETS)
+        m_buffers[slot] = buffer;
+    m_issued++;
+}
+
+/*static*/ void RGLState::setBlending(bool enabled)
+{
+    if(m_blending == int(enabled))
+    {
+        m_skipped++;
+        return;
+    }
+
+    if(enabled)
+        glEnable(GL_BLEND);
+    else
+        glDisable(GL_BLEND);
+    m_blending = enabled;
+    m_issued++;
+}
+
+/*static*/ void RGLState::blendFunc(GLenum src, GLenum dst)
+{
+    if(m_blendSrc == src && m_blendDst == dst)
+    {
+        m_skipped++;
+        return;
+    }
+
+    glBlendFunc(src, dst);
+    m_blendSrc = src;
+    m_blendDst = dst;
+    m_issued++;
+}
+
+/*static*/ void RGLState::deleteProgram(GLuint program)
+{
+    glDeleteProgram(program);
+    RMemoryTracker::release(MEMORY_PROGRAMS, program);
+
+    if(m_program == program)
+        m_program = UNKNOWN;
+}
+
+/*static*/ void RGLState::deleteTexture(GLuint texture)
+{
+    glDeleteTextures(1, &texture);
+    RMemoryTracker::release(MEMORY_TEXTURES, texture);
+
+    for(unsigned i = 0; i < MAX_TEXTURE_UNITS; ++i)
+        if(m_textures[i] == texture)
+            m_textures[i] = 0;
+}
+
+/*static*/ void RGLState::deleteVertexArray(GLuint vao)
+{
+    glDeleteVertexArrays(1, &vao);
+
+    if(m_vertexArray == vao)
+        m_vertexArray = 0;
+}
+
+/*static*/ void RGLState::deleteBuffer(GLuint buffer)
+{
+    glDeleteBuffers(1, &buffer);
+    RMemoryTracker::release(MEMORY_BUFFERS, buffer);
+
+    for(unsigned i = 0; i < BUFFER_TARGETS; ++i)
+        if(m_buffers[i] == buffer)
+            m_buffers[i] = 0;
+}
+
+/*static*/ unsigned RGLState::getIssuedCalls()
+{
+    return m_lastIssued;
+}
+
+/*static*/ unsigned RGLState::getSkippedCalls()
+{
+    return m_lastSkipped;
+}
+
+/*static*/ unsigned RGLState::bufferSlot(GLenum target)
+{
+    switch(target)
+    {
+        case GL_ARRAY_BUFFER:
+            return 0;
+        case GL_PIXEL_PACK_BUFFER:
+            return 1;
+        case GL_PIXEL_UNPACK_BUFFER:
+            return 2;
+        case GL_UNIFORM_BUFFER:
+            return 3;
+        case GL_COPY_WRITE_BUFFER:
+            return 4;
+    }
+
+    return BUFFER_TARGETS;
+}
+
+/*static*/ void RGLState::countDraw(unsigned long triangles)
+{
+    m_counters.drawCalls++;
+    m_counters.triangles += triangles;
+}
+
+/*static*/ void RGLState::countBufferUpload(unsigned long bytes)
+{
+    m_counters.bufferBytes += bytes;
+}
+
+/*static*/ void RGLState::countTextureUpload(unsigned long bytes)
+{
+    m_counters.textureBytes += bytes;
+}
+
+/*static*/ RGLCounters RGLState::getFrameCounters()
+{
+    return m_counters;
+}
+}
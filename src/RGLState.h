@@ -0,0 +1,182 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RGLSTATE_H
+#define RGLSTATE_H
+
+//GLEW
+#include <GL/glew.h>
+
+namespace Realio {
+//Work of one frame
+struct RGLCounters
+{
+    unsigned programBinds;
+    unsigned textureBinds;
+    unsigned vertexArrayBinds;
+    unsigned drawCalls;
+    unsigned long triangles;
+    unsigned long bufferBytes;
+    unsigned long textureBytes;
+};
+
+class RGLState
+{
+public:
+    /**
+     * @brief forgets everything known about the context, so the next calls
+     * are issued. Call it after creating a context or running foreign GL code.
+     * @param void.
+     * @return void.
+     */
+    static void invalidate();
+
+    /**
+     * @brief starts counting calls of a new frame.
+     * @param void.
+     * @return void.
+     */
+    static void beginFrame();
+
+    /**
+     * @brief binds the program, if it's not bound yet.
+     * @param program, placed in GLuint.
+     * @return void.
+     */
+    static void useProgram(GLuint program);
+
+    /**
+     * @brief binds 2D texture to the unit, if it's not bound there yet.
+     * @param texture and index of the unit.
+     * @return void.
+     */
+    static void bindTexture(GLuint texture, unsigned unit = 0);
+
+    /**
+     * @brief binds the vertex array, if it's not bound yet.
+     * @param VAO, placed in GLuint.
+     * @return void.
+     */
+    static void bindVertexArray(GLuint vao);
+
+    /**
+     * @brief binds the buffer to the target, if it's not bound yet.
+     * GL_ELEMENT_ARRAY_BUFFER belongs to the VAO and is always bound.
+     * @param target and buffer.
+     * @return void.
+     */
+    static void bindBuffer(GLenum target, GLuint buffer);
+
+    /**
+     * @brief enables or disables blending, if it's not in this state yet.
+     * @param true to enable blending.
+     * @return void.
+     */
+    static void setBlending(bool enabled);
+
+    /**
+     * @brief sets the blending function, if it differs from the current one.
+     * @param source and destination factors.
+     * @return void.
+     */
+    static void blendFunc(GLenum src, GLenum dst);
+
+    /**
+     * @brief deletes objects and forgets their bindings. Programs, textures
+     * and buffers are released from RMemoryTracker too.
+     * @param object, placed in GLuint.
+     * @return void.
+     */
+    static void deleteProgram(GLuint program);
+    static void deleteTexture(GLuint texture);
+    static void deleteVertexArray(GLuint vao);
+    static void deleteBuffer(GLuint buffer);
+
+    /**
+     * @brief returns number of state calls issued during the last frame.
+     * @param void.
+     * @return number of calls.
+     */
+    static unsigned getIssuedCalls();
+
+    /**
+     * @brief returns number of state calls skipped during the last frame.
+     * @param void.
+     * @return number of calls.
+     */
+    static unsigned getSkippedCalls();
+
+    /**
+     * @brief counts a draw call.
+     * @param number of drawn triangles.
+     * @return void.
+     */
+    static void countDraw(unsigned long triangles);
+
+    /**
+     * @brief counts bytes uploaded to buffers.
+     * @param number of bytes.
+     * @return void.
+     */
+    static void countBufferUpload(unsigned long bytes);
+
+    /**
+     * @brief counts bytes uploaded to textures.
+     * @param number of bytes.
+     * @return void.
+     */
+    static void countTextureUpload(unsigned long bytes);
+
+    /**
+     * @brief returns the work done since the last beginFrame().
+     * @param void.
+     * @return counters of the current frame.
+     */
+    static RGLCounters getFrameCounters();
+
+private:
+    static const unsigned MAX_TEXTURE_UNITS = 16;
+    static const unsigned BUFFER_TARGETS = 5;
+
+    static GLuint m_program;
+    static unsigned m_activeUnit;
+    static GLuint m_textures[MAX_TEXTURE_UNITS];
+    static GLuint m_vertexArray;
+    static GLuint m_buffers[BUFFER_TARGETS];
+    static int m_blending;
+    static GLenum m_blendSrc, m_blendDst;
+
+    static unsigned m_issued, m_skipped;
+    static unsigned m_lastIssued, m_lastSkipped;
+    static RGLCounters m_counters;
+
+    /**
+     * @brief returns slot of the buffer target in m_buffers.
+     * @param target.
+     * @return index, BUFFER_TARGETS if the target isn't tracked.
+     */
+    static unsigned bufferSlot(GLenum target);
+
+    /**
+     * @brief makes the unit active, if it's not active yet.
+     * @param index of the unit.
+     * @return void.
+     */
+    static void activeTexture(unsigned unit);
+};
+}
+
+#endif // RGLSTATE_H
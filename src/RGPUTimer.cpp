@@ -0,0 +1,152 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RGPUTimer.h"
+//C++
+#include <cstring>
+
+namespace Realio {
+RGPUTimer::RGPUTimer(const unsigned latency)
+{
+    m_supported = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+
+    m_frames.resize(latency > 0 ? latency : 1);
+    for(unsigned i = 0; i < m_frames.size(); ++i)
+    {
+        m_frames[i].used = 0;
+        m_frames[i].index = 0;
+        m_frames[i].pending = false;
+    }
+
+    m_current = 0;
+    m_frameIndex = 0;
+    m_recording = false;
+
+    std::memset(&m_last, 0, sizeof(m_last));
+}
+
+RGPUTimer::~RGPUTimer()
+{
+    for(unsigned i = 0; i < m_frames.size(); ++i)
+        if(!m_frames[i].queries.empty())
+            glDeleteQueries(m_frames[i].queries.size(), m_frames[i].queries.data());
+}
+
+void RGPUTimer::beginFrame()
+{
+    m_frameIndex++;
+    m_recording = false;
+
+    if(!m_supported)
+        return;
+
+    // Oldest frames first, so the last collected is the newest
+    for(unsigned i = 1; i <= m_frames.size(); ++i)
+    {
+        Frame &frame = m_frames[(m_current + i) % m_frames.size()];
+        if(frame.pending && !collect(frame))
+            break;
+    }
+
+    m_current = (m_current + 1) % m_frames.size();
+    Frame &frame = m_frames[m_current];
+
+    // The GPU is too far behind, skip the frame instead of waiting
+    if(frame.pending)
+        return;
+
+    frame.used = 0;
+    frame.index = m_frameIndex;
+    m_recording = true;
+}
+
+void RGPUTimer::mark(RGPUScope scope)
+{
+    if(!m_recording)
+        return;
+
+    Frame &frame = m_frames[m_current];
+
+    if(frame.used == frame.queries.size())
+    {
+        GLuint query;
+        glGenQueries(1, &query);
+        frame.queries.push_back(query);
+        frame.scopes.push_back(scope);
+    }
+
+    glQueryCounter(frame.queries[frame.used], GL_TIMESTAMP);
+    frame.scopes[frame.used] = scope;
+    frame.used++;
+}
+
+void RGPUTimer::endFrame()
+{
+    if(!m_recording)
+        return;
+
+    mark(GPU_SCOPE_COUNT);
+
+    // A frame needs two stamps to measure anything
+    m_frames[m_current].pending = m_frames[m_current].used > 1;
+    m_recording = false;
+}
+
+bool RGPUTimer::isSupported()
+{
+    return m_supported;
+}
+
+RGPUFrameTimes RGPUTimer::getLastFrame()
+{
+    return m_last;
+}
+
+bool RGPUTimer::collect(Frame &frame)
+{
+    // Stamps are done in order, so the last one is ready only after the others
+    GLint available = 0;
+    glGetQueryObjectiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if(!available)
+        return false;
+
+    RGPUFrameTimes times;
+    std::memset(&times, 0, sizeof(times));
+    times.frame = frame.index;
+
+    GLuint64 previous = 0;
+    for(unsigned i = 0; i < frame.used; ++i)
+    {
+        GLuint64 stamp = 0;
+        glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &stamp);
+
+        if(i > 0)
+        {
+            double time = (stamp - previous) / 1000000.0;
+            if(frame.scopes[i - 1] < GPU_SCOPE_COUNT)
+                times.scopes[frame.scopes[i - 1]] += time;
+            times.total += time;
+        }
+        previous = stamp;
+    }
+
+    m_last = times;
+    frame.pending = false;
+
+    return true;
+}
+}
@@ -0,0 +1,118 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RGPUTIMER_H
+#define RGPUTIMER_H
+
+//C++
+#include <vector>
+//GLEW
+#include <GL/glew.h>
+
+namespace Realio {
+//Parts of a frame timed on the GPU
+typedef enum
+{
+    GPU_SCOPE_CLEAR,                          //Clearing the damaged areas
+    GPU_SCOPE_WIDGETS,                        //Drawing widgets
+    GPU_SCOPE_CURSOR,                         //Drawing the cursor
+    GPU_SCOPE_PRESENT,                        //Capturing, blitting and swapping
+    GPU_SCOPE_COUNT
+} RGPUScope;
+
+struct RGPUFrameTimes
+{
+    // Number of the frame, starting from 1. 0 if nothing is measured yet
+    unsigned frame;
+    // Milliseconds spent in every scope and in the whole frame
+    double scopes[GPU_SCOPE_COUNT];
+    double total;
+};
+
+class RGPUTimer
+{
+public:
+    /**
+     * @brief creates a ring of query sets. Results are read when they are
+     * ready, so the CPU never waits for the GPU.
+     * @param number of frames the GPU may lag behind.
+     */
+    explicit RGPUTimer(const unsigned latency = 3);
+    ~RGPUTimer();
+
+    /**
+     * @brief collects finished frames and starts timing a new one.
+     * The frame isn't timed, if all query sets are still in flight.
+     * @param void.
+     * @return void.
+     */
+    void beginFrame();
+
+    /**
+     * @brief stamps the GPU's time. Everything after the stamp is counted
+     * to the scope until the next stamp, so scopes may interleave.
+     * @param scope.
+     * @return void.
+     */
+    void mark(RGPUScope scope);
+
+    /**
+     * @brief stamps the end of the frame.
+     * @param void.
+     * @return void.
+     */
+    void endFrame();
+
+    /**
+     * @brief returns true if the context supports timer queries.
+     * @param void.
+     * @return true, if frames are timed. false, if not.
+     */
+    bool isSupported();
+
+    /**
+     * @brief returns timings of the last frame the GPU has finished.
+     * @param void.
+     * @return times of the frame's scopes.
+     */
+    RGPUFrameTimes getLastFrame();
+
+private:
+    struct Frame {
+        std::vector<GLuint> queries;
+        std::vector<RGPUScope> scopes;
+        unsigned used;
+        unsigned index;
+        bool pending;
+    };
+    std::vector<Frame> m_frames;
+    unsigned m_current;
+    unsigned m_frameIndex;
+    bool m_recording;
+    bool m_supported;
+
+    RGPUFrameTimes m_last;
+
+    /**
+     * @brief reads the frame's queries, if they are ready.
+     * @param frame.
+     * @return true, if the results are read. false, if the GPU isn't done yet.
+     */
+    bool collect(Frame &frame);
+};
+}
+
+#endif // RGPUTIMER_H
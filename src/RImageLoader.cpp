@@ -0,0 +1,347 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RImageLoader.h"
+#include "RAssetPack.h"
+#include "RGLState.h"
+#include "RMemoryTracker.h"
+#include "RMipmapBuilder.h"
+#include "RPixmap.h"
+#include "RProfiler.h"
+#include "RTextureCache.h"
+//C++
+#include <algorithm>
+#include <iostream>
+#include <utility>
+//STB
+#include "stb/stb_image.h"
+
+namespace Realio {
+std::vector<std::thread> RImageLoader::m_workers;
+std::deque<RImageLoader::Job> RImageLoader::m_jobs;
+std::deque<RImageLoader::Job> RImageLoader::m_done;
+bool RImageLoader::m_running = false;
+std::mutex RImageLoader::m_mutex;
+std::condition_variable RImageLoader::m_condition;
+std::map<unsigned, RImageLoader::Request> RImageLoader::m_requests;
+std::map<std::string, unsigned> RImageLoader::m_shared;
+unsigned RImageLoader::m_nextTicket = 1;
+GLuint RImageLoader::m_placeholder = 0;
+
+/*static*/ void RImageLoader::start(unsigned threads)
+{
+    if(!m_workers.empty())
+        return;
+
+    if(threads == 0)
+        threads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+    m_running = true;
+    for(unsigned i = 0; i < threads; ++i)
+        m_workers.push_back(std::thread(&RImageLoader::workerLoop));
+}
+
+/*static*/ void RImageLoader::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_condition.notify_all();
+
+    for(unsigned i = 0; i < m_workers.size(); ++i)
+        m_workers[i].join();
+    m_workers.clear();
+
+    m_jobs.clear();
+    for(unsigned i = 0; i < m_done.size(); ++i)
+        freeImage(m_done[i]);
+    m_done.clear();
+
+    std::map<unsigned, Request>::iterator it;
+    for(it = m_requests.begin(); it != m_requests.end(); ++it)
+        it->second.promise.set_value(false);
+    m_requests.clear();
+    m_shared.clear();
+
+    if(m_placeholder)
+    {
+        RGLState::deleteTexture(m_placeholder);
+        m_placeholder = 0;
+    }
+}
+
+/*static*/ std::shared_future<bool> RImageLoader::request(RPixmap *pixmap, const char *file,
+                                                         void (*callback)(RPixmap *pixmap, bool loaded),
+                                                         unsigned &ticket, bool shared)
+{
+    start();
+
+    ticket = m_nextTicket++;
+
+    Request &request = m_requests[ticket];
+    request.pixmap = pixmap;
+    request.callback = callback;
+    request.job = ticket;
+
+    if(shared)
+    {
+        // Another pixmap waits for the file already
+        std::map<std::string, unsigned>::iterator it = m_shared.find(file);
+        if(it != m_shared.end())
+        {
+            request.job = it->second;
+            return request.promise.get_future().share();
+        }
+        m_shared[file] = ticket;
+    }
+
+    Job job;
+    job.ticket = ticket;
+    job.file = file;
+    // RTextureCache moves a shared image to its first user
+    job.owner = pixmap->getID();
+    job.image = nullptr;
+    job.mips = nullptr;
+    job.width = job.height = job.comp = 0;
+    job.shared = shared;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(job);
+    }
+    m_condition.notify_one();
+
+    return request.promise.get_future().share();
+}
+
+/*static*/ void RImageLoader::cancel(unsigned ticket)
+{
+    std::map<unsigned, Request>::iterator it = m_requests.find(ticket);
+    if(it == m_requests.end())
+        return;
+
+    unsigned job = it->second.job;
+    it->second.promise.set_value(false);
+    m_requests.erase(it);
+
+    // The job goes on for other requests of the file
+    for(it = m_requests.begin(); it != m_requests.end(); ++it)
+        if(it->second.job == job)
+            return;
+
+    std::map<std::string, unsigned>::iterator shared;
+    for(shared = m_shared.begin(); shared != m_shared.end(); ++shared)
+    {
+        if(shared->second == job)
+        {
+            m_shared.erase(shared);
+            break;
+        }
+    }
+
+    // Don't decode what nobody waits for; a finished image is freed in dispatch()
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(unsigned i = 0; i < m_jobs.size(); ++i)
+    {
+        if(m_jobs[i].ticket == job)
+        {
+            m_jobs.erase(m_jobs.begin() + i);
+            break;
+        }
+    }
+}
+
+/*static*/ unsigned RImageLoader::dispatch()
+{
+    std::deque<Job> done;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        done.swap(m_done);
+    }
+
+    unsigned finished = 0;
+    for(unsigned i = 0; i < done.size(); ++i)
+    {
+        Job &job = done[i];
+
+        // Later requests of the file start a new job
+        if(job.shared)
+        {
+            std::map<std::string, unsigned>::iterator shared = m_shared.find(job.file);
+            if(shared != m_shared.end() && shared->second == job.ticket)
+                m_shared.erase(shared);
+        }
+
+        std::vector<unsigned> tickets;
+        std::map<unsigned, Request>::iterator it;
+        for(it = m_requests.begin(); it != m_requests.end(); ++it)
+            if(it->second.job == job.ticket)
+                tickets.push_back(it->first);
+
+        if(tickets.empty())
+        {
+            freeImage(job);
+            continue;
+        }
+
+        bool loaded = job.image != nullptr;
+        if(!loaded)
+            std::cerr << "Could not load image '" << job.file << "' to RPixmap: " <<
+                         job.error << std::endl;
+
+        if(job.shared)
+        {
+            finished += dispatchShared(job, tickets);
+            continue;
+        }
+
+        // The callback may request again, so take the request out first
+        it = m_requests.find(tickets[0]);
+        Request request = std::move(it->second);
+        m_requests.erase(it);
+
+        // The pixmap owns the image from now on
+        request.pixmap->imageDecoded(job.ticket, job.image, job.mips, job.width, job.height, job.comp);
+
+        if(request.callback != nullptr)
+            request.callback(request.pixmap, loaded);
+        request.promise.set_value(loaded);
+
+        finished++;
+    }
+
+    return finished;
+}
+
+/*static*/ unsigned RImageLoader::dispatchShared(Job &job, const std::vector<unsigned> &tickets)
+{
+    unsigned finished = 0;
+    bool inserted = false;
+
+    for(unsigned i = 0; i < tickets.size(); ++i)
+    {
+        // A callback may delete another pixmap waiting for the file
+        std::map<unsigned, Request>::iterator it = m_requests.find(tickets[i]);
+        if(it == m_requests.end())
+            continue;
+
+        Request request = std::move(it->second);
+        m_requests.erase(it);
+
+        // The cache owns the image from now on. If callbacks released it
+        // meanwhile, the file is decoded again
+        RCachedTexture *entry = nullptr;
+        if(job.image && !inserted)
+        {
+            entry = RTextureCache::insert(job.file.c_str(), job.image, job.mips,
+                                          job.width, job.height, request.pixmap);
+            inserted = true;
+        }
+        else if(job.image)
+            entry = RTextureCache::acquire(job.file.c_str(), request.pixmap);
+
+        bool loaded = entry != nullptr;
+        request.pixmap->imageCached(tickets[i], entry);
+
+        if(request.callback != nullptr)
+            request.callback(request.pixmap, loaded);
+        request.promise.set_value(loaded);
+
+        finished++;
+    }
+
+    if(!inserted)
+        freeImage(job);
+
+    return finished;
+}
+
+/*static*/ unsigned RImageLoader::getPendingCount()
+{
+    return m_requests.size();
+}
+
+/*static*/ GLuint RImageLoader::getPlaceholder()
+{
+    if(m_placeholder)
+        return m_placeholder;
+
+    const unsigned char grey[4] = {128, 128, 128, 255};
+
+    glGenTextures(1, &m_placeholder);
+    RGLState::bindTexture(m_placeholder);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+
+    RMemoryTracker::allocate(MEMORY_TEXTURES, m_placeholder, sizeof(grey));
+
+    return m_placeholder;
+}
+
+/*static*/ void RImageLoader::workerLoop()
+{
+    for(;;)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while(m_running && m_jobs.empty())
+                m_condition.wait(lock);
+
+            if(!m_running)
+                return;
+
+            job = m_jobs.front();
+            m_jobs.pop_front();
+        }
+
+        {
+            REALIO_PROFILE_ZONE("stbi_load");
+            job.image = RAssetPack::loadImage(job.file.c_str(), job.width, job.height, job.comp, job.error);
+        }
+
+        if(job.image)
+        {
+            RMemoryTracker::allocate(MEMORY_DECODED_IMAGES, (uintptr_t)job.image,
+                                     job.width * job.height * 4, job.owner);
+
+            // Other workers decode meanwhile, so the mipmaps take one thread
+            if(RMipmapBuilder::isEnabled())
+                job.mips = RMipmapBuilder::build(job.image, job.width, job.height, job.owner, 1);
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_done.push_back(job);
+    }
+}
+
+/*static*/ void RImageLoader::freeImage(Job &job)
+{
+    if(!job.image)
+        return;
+
+    RMemoryTracker::release(MEMORY_DECODED_IMAGES, (uintptr_t)job.image);
+    stbi_image_free(job.image);
+    job.image = nullptr;
+
+    RMipmapBuilder::destroy(job.mips);
+    job.mips = nullptr;
+}
+}
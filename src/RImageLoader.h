@@ -0,0 +1,154 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RIMAGELOADER_H
+#define RIMAGELOADER_H
+
+//C++
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+//GLEW
+#include <GL/glew.h>
+
+namespace Realio {
+class RPixmap;
+struct RMipChain;
+
+class RImageLoader
+{
+public:
+    /**
+     * @brief starts the decoding threads. request() starts them on demand too.
+     * @param number of threads, 0 to leave one core to the rendering thread.
+     * @return void.
+     */
+    static void start(unsigned threads = 0);
+
+    /**
+     * @brief stops the threads. Unfinished loads are dropped and their
+     * futures get false.
+     * @param void.
+     * @return void.
+     */
+    static void stop();
+
+    /**
+     * @brief queues the file for decoding. The pixmap gets the image on the
+     * rendering thread in dispatch(), then the callback is called and the future is set.
+     * A shared image goes to RTextureCache instead and shared requests of one
+     * file wait for the same decode, each pixmap gets a reference to the entry.
+     * @param pixmap, path to the file, function to call (may be nullptr), place
+     * for the ticket and true to share the image.
+     * @return future, which is true if the image is loaded. Don't wait for it
+     * on the rendering thread, it's set there.
+     */
+    static std::shared_future<bool> request(RPixmap *pixmap, const char *file,
+                                            void (*callback)(RPixmap *pixmap, bool loaded),
+                                            unsigned &ticket, bool shared = false);
+
+    /**
+     * @brief forgets the request, e.g. when its pixmap is deleted.
+     * @param ticket of the request.
+     * @return void.
+     */
+    static void cancel(unsigned ticket);
+
+    /**
+     * @brief hands decoded images to their pixmaps. Call it on the rendering thread.
+     * @param void.
+     * @return number of finished requests.
+     */
+    static unsigned dispatch();
+
+    /**
+     * @brief returns number of requests, which are not dispatched yet.
+     * @param void.
+     * @return number of requests.
+     */
+    static unsigned getPendingCount();
+
+    /**
+     * @brief returns the texture drawn by pixmaps, while their images are loading.
+     * @param void.
+     * @return 1x1 grey texture.
+     */
+    static GLuint getPlaceholder();
+
+private:
+    struct Job {
+        unsigned ticket;
+        std::string file;
+        unsigned owner;
+        unsigned char *image;
+        RMipChain *mips;
+        int width, height, comp;
+        std::string error;
+        bool shared;
+    };
+
+    struct Request {
+        RPixmap *pixmap;
+        void (*callback)(RPixmap *pixmap, bool loaded);
+        std::promise<bool> promise;
+        // Ticket of the job decoding the file, the request's own one unless it's shared
+        unsigned job;
+    };
+
+    static std::vector<std::thread> m_workers;
+    static std::deque<Job> m_jobs;
+    static std::deque<Job> m_done;
+    static bool m_running;
+    static std::mutex m_mutex;
+    static std::condition_variable m_condition;
+
+    // Only the rendering thread touches these
+    static std::map<unsigned, Request> m_requests;
+    // Jobs of shared requests by file, until they are dispatched
+    static std::map<std::string, unsigned> m_shared;
+    static unsigned m_nextTicket;
+    static GLuint m_placeholder;
+
+    /**
+     * @brief decodes queued files and, if RMipmapBuilder is enabled, builds
+     * their mipmaps until the loader is stopped.
+     * @param void.
+     * @return void.
+     */
+    static void workerLoop();
+
+    /**
+     * @brief hands a shared job's image to RTextureCache and its requests.
+     * @param job and tickets of the requests waiting for it.
+     * @return number of finished requests.
+     */
+    static unsigned dispatchShared(Job &job, const std::vector<unsigned> &tickets);
+
+    /**
+     * @brief frees the job's image and its mipmaps, if there are ones.
+     * @param job.
+     * @return void.
+     */
+    static void freeImage(Job &job);
+};
+}
+
+#endif // RIMAGELOADER_H
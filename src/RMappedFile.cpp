@@ -0,0 +1,104 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RMappedFile.h"
+//C++
+#include <fstream>
+#include <iterator>
+//POSIX
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define REALIO_HAS_MMAP
+#endif
+
+namespace Realio {
+RMappedFile::RMappedFile()
+{
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+}
+
+RMappedFile::~RMappedFile()
+{
+    close();
+}
+
+bool RMappedFile::open(const char *path)
+{
+    close();
+
+#ifdef REALIO_HAS_MMAP
+    int fd = ::open(path, O_RDONLY);
+    if(fd >= 0)
+    {
+        struct stat info;
+        if(fstat(fd, &info) == 0 && info.st_size > 0)
+        {
+            void *memory = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(memory != MAP_FAILED)
+            {
+                m_data = (const unsigned char*)memory;
+                m_size = info.st_size;
+                m_mapped = true;
+            }
+        }
+        ::close(fd);
+    }
+#endif
+
+    // Without mmap the file is read as a whole
+    if(m_data == nullptr)
+    {
+        std::ifstream file(path, std::ios::binary);
+        m_buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        if(!m_buffer.empty())
+        {
+            m_data = m_buffer.data();
+            m_size = m_buffer.size();
+        }
+    }
+
+    return m_data != nullptr;
+}
+
+void RMappedFile::close()
+{
+#ifdef REALIO_HAS_MMAP
+    if(m_mapped)
+        munmap((void*)m_data, m_size);
+#endif
+
+    m_buffer.clear();
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+}
+
+const unsigned char* RMappedFile::getData()
+{
+    return m_data;
+}
+
+size_t RMappedFile::getSize()
+{
+    return m_size;
+}
+}
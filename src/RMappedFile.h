@@ -0,0 +1,69 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RMAPPEDFILE_H
+#define RMAPPEDFILE_H
+
+//C++
+#include <cstddef>
+#include <vector>
+
+namespace Realio {
+class RMappedFile
+{
+public:
+    RMappedFile();
+    ~RMappedFile();
+
+    /**
+     * @brief maps the whole file into memory read-only. Where there is no
+     * mmap, the file is read instead.
+     * @param path to the file.
+     * @return true, if the file is mapped. false, if it can't be opened or is empty.
+     */
+    bool open(const char *path);
+
+    /**
+     * @brief unmaps the file.
+     * @param void.
+     * @return void.
+     */
+    void close();
+
+    /**
+     * @brief returns contents of the file.
+     * @param void.
+     * @return pointer to the first byte, nullptr if nothing is open.
+     */
+    const unsigned char* getData();
+
+    /**
+     * @brief returns size of the file.
+     * @param void.
+     * @return number of bytes.
+     */
+    size_t getSize();
+
+private:
+    const unsigned char *m_data;
+    size_t m_size;
+    // Mapped files are unmapped, read ones are kept here
+    bool m_mapped;
+    std::vector<unsigned char> m_buffer;
+};
+}
+
+#endif // RMAPPEDFILE_H
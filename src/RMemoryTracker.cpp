@@ -0,0 +1,160 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RMemoryTracker.h"
+//C++
+#include <algorithm>
+#include <vector>
+
+namespace Realio {
+namespace {
+const char *categoryNames[MEMORY_CATEGORY_COUNT] = {
+    "decoded images",
+    "textures",
+    "render targets",
+    "buffers",
+    "programs"
+};
+
+// Number of owners listed in the report
+const unsigned REPORTED_OWNERS = 10;
+
+bool biggerOwner(const std::pair<unsigned, size_t> &a, const std::pair<unsigned, size_t> &b)
+{
+    return a.second > b.second;
+}
+}
+
+std::map<std::pair<int, uintptr_t>, RMemoryTracker::Allocation> RMemoryTracker::m_allocations;
+size_t RMemoryTracker::m_bytes[MEMORY_CATEGORY_COUNT];
+size_t RMemoryTracker::m_peakBytes[MEMORY_CATEGORY_COUNT];
+std::mutex RMemoryTracker::m_mutex;
+
+/*static*/ void RMemoryTracker::allocate(RMemoryCategory category, uintptr_t handle, size_t bytes, unsigned owner)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Allocation &allocation = m_allocations[std::make_pair((int)category, handle)];
+    m_bytes[category] -= allocation.bytes;
+
+    allocation.bytes = bytes;
+    allocation.owner = owner;
+    m_bytes[category] += bytes;
+
+    m_peakBytes[category] = std::max(m_peakBytes[category], m_bytes[category]);
+}
+
+/*static*/ void RMemoryTracker::release(RMemoryCategory category, uintptr_t handle)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::map<std::pair<int, uintptr_t>, Allocation>::iterator it;
+    it = m_allocations.find(std::make_pair((int)category, handle));
+    if(it == m_allocations.end())
+        return;
+
+    m_bytes[category] -= it->second.bytes;
+    m_allocations.erase(it);
+}
+
+/*static*/ void RMemoryTracker::setOwner(RMemoryCategory category, uintptr_t handle, unsigned owner)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::map<std::pair<int, uintptr_t>, Allocation>::iterator it;
+    it = m_allocations.find(std::make_pair((int)category, handle));
+    if(it != m_allocations.end())
+        it->second.owner = owner;
+}
+
+/*static*/ size_t RMemoryTracker::getBytes(RMemoryCategory category)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes[category];
+}
+
+/*static*/ size_t RMemoryTracker::getPeakBytes(RMemoryCategory category)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_peakBytes[category];
+}
+
+/*static*/ size_t RMemoryTracker::getWidgetBytes(unsigned widget, RMemoryCategory category)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    size_t bytes = 0;
+    std::map<std::pair<int, uintptr_t>, Allocation>::iterator it;
+    for(it = m_allocations.begin(); it != m_allocations.end(); ++it)
+        if(it->first.first == category && it->second.owner == widget)
+            bytes += it->second.bytes;
+
+    return bytes;
+}
+
+/*static*/ size_t RMemoryTracker::getTotalBytes()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    size_t bytes = 0;
+    for(unsigned i = 0; i < MEMORY_CATEGORY_COUNT; ++i)
+        bytes += m_bytes[i];
+
+    return bytes;
+}
+
+/*static*/ void RMemoryTracker::report(std::ostream &out)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    out << "Realio memory (in use / peak, KiB):" << std::endl;
+    for(unsigned i = 0; i < MEMORY_CATEGORY_COUNT; ++i)
+        out << "  " << categoryNames[i] << ": " << m_bytes[i] / 1024 <<
+               " / " << m_peakBytes[i] / 1024 << std::endl;
+
+    std::map<unsigned, size_t> owners;
+    std::map<std::pair<int, uintptr_t>, Allocation>::iterator it;
+    for(it = m_allocations.begin(); it != m_allocations.end(); ++it)
+        owners[it->second.owner] += it->second.bytes;
+
+    std::vector<std::pair<unsigned, size_t> > sorted(owners.begin(), owners.end());
+    std::sort(sorted.begin(), sorted.end(), biggerOwner);
+
+    for(unsigned i = 0; i < sorted.size() && i < REPORTED_OWNERS; ++i)
+    {
+        if(sorted[i].first == 0)
+            out << "  engine: ";
+        else
+            out << "  widget " << sorted[i].first << ": ";
+        out << sorted[i].second / 1024 << " KiB" << std::endl;
+    }
+}
+
+/*static*/ size_t RMemoryTracker::textureSize(int width, int height, int bytesPerPixel, bool mipmaps)
+{
+    size_t bytes = (size_t)width * height * bytesPerPixel;
+
+    while(mipmaps && (width > 1 || height > 1))
+    {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        bytes += (size_t)width * height * bytesPerPixel;
+    }
+
+    return bytes;
+}
+}
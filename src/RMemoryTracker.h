@@ -0,0 +1,123 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RMEMORYTRACKER_H
+#define RMEMORYTRACKER_H
+
+//C++
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace Realio {
+//Kinds of tracked memory
+typedef enum
+{
+    MEMORY_DECODED_IMAGES,                    //Decoded pixels in RAM
+    MEMORY_TEXTURES,                          //Textures with their mipmaps
+    MEMORY_RENDER_TARGETS,                    //Renderbuffers
+    MEMORY_BUFFERS,                           //Vertex, index, uniform and pixel buffers
+    MEMORY_PROGRAMS,                          //Linked shader programs
+    MEMORY_CATEGORY_COUNT
+} RMemoryCategory;
+
+class RMemoryTracker
+{
+public:
+    /**
+     * @brief records a resource. Recording the same handle again replaces it,
+     * e.g. when a texture is uploaded once more.
+     * @param category, handle (GL name or pointer), size and ID of the owning widget, 0 for the engine.
+     * @return void.
+     */
+    static void allocate(RMemoryCategory category, uintptr_t handle, size_t bytes, unsigned owner = 0);
+
+    /**
+     * @brief forgets a resource. Unknown handles are ignored.
+     * @param category and handle.
+     * @return void.
+     */
+    static void release(RMemoryCategory category, uintptr_t handle);
+
+    /**
+     * @brief gives a recorded resource to another owner, e.g. when the widget
+     * charged for a shared one is gone. Unknown handles are ignored.
+     * @param category, handle and ID of the new owner, 0 for the engine.
+     * @return void.
+     */
+    static void setOwner(RMemoryCategory category, uintptr_t handle, unsigned owner);
+
+    /**
+     * @brief returns bytes of the category in use.
+     * @param category.
+     * @return number of bytes.
+     */
+    static size_t getBytes(RMemoryCategory category);
+
+    /**
+     * @brief returns the most bytes the category has used at once.
+     * @param category.
+     * @return number of bytes.
+     */
+    static size_t getPeakBytes(RMemoryCategory category);
+
+    /**
+     * @brief returns bytes of the category owned by the widget. Images and
+     * textures shared through RTextureCache count for the first pixmap using them.
+     * @param ID of the widget and category.
+     * @return number of bytes.
+     */
+    static size_t getWidgetBytes(unsigned widget, RMemoryCategory category);
+
+    /**
+     * @brief returns bytes of all categories in use.
+     * @param void.
+     * @return number of bytes.
+     */
+    static size_t getTotalBytes();
+
+    /**
+     * @brief writes usage per category and the biggest owners.
+     * @param stream to write to.
+     * @return void.
+     */
+    static void report(std::ostream &out);
+
+    /**
+     * @brief returns size of a texture.
+     * @param size of the base level, bytes per pixel and whether it has mipmaps.
+     * @return number of bytes.
+     */
+    static size_t textureSize(int width, int height, int bytesPerPixel, bool mipmaps);
+
+private:
+    struct Allocation {
+        size_t bytes;
+        unsigned owner;
+    };
+
+    static std::map<std::pair<int, uintptr_t>, Allocation> m_allocations;
+    static size_t m_bytes[MEMORY_CATEGORY_COUNT];
+    static size_t m_peakBytes[MEMORY_CATEGORY_COUNT];
+    // Decoding threads record images too
+    static std::mutex m_mutex;
+};
+}
+
+#endif // RMEMORYTRACKER_H
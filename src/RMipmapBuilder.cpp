@@ -0,0 +1,252 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RMipmapBuilder.h"
+#include "RGLState.h"
+#include "RMemoryTracker.h"
+#include "RProfiler.h"
+//C++
+#include <algorithm>
+#include <cmath>
+#include <thread>
+//SSE2
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace Realio {
+namespace {
+// Levels smaller than that aren't worth a thread
+const int PARALLEL_PIXELS = 128 * 128;
+// Steps of linear light looked up to get back to sRGB
+const int LINEAR_STEPS = 4096;
+
+struct ColorTables {
+    float linear[256];
+    unsigned char srgb[LINEAR_STEPS];
+
+    ColorTables()
+    {
+        for(int i = 0; i < 256; ++i)
+        {
+            float c = i / 255.0f;
+            linear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+
+        for(int i = 0; i < LINEAR_STEPS; ++i)
+        {
+            float l = i / float(LINEAR_STEPS - 1);
+            float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+            srgb[i] = (unsigned char)(c * 255.0f + 0.5f);
+        }
+    }
+};
+
+// Built once on first use, threads may race to it safely
+const ColorTables& colorTables()
+{
+    static ColorTables tables;
+    return tables;
+}
+
+// Source pixels and their weights for a pixel of the halved size. Even sizes average
+// pairs, odd ones a box of size / (size / 2) pixels that overlaps its neighbours
+int filterTaps(int size, int index, int *taps, float *weights)
+{
+    if(size == 1)
+    {
+        taps[0] = 0;
+        weights[0] = 1.0f;
+        return 1;
+    }
+
+    if(size % 2 == 0)
+    {
+        taps[0] = index * 2;
+        taps[1] = index * 2 + 1;
+        weights[0] = weights[1] = 0.5f;
+        return 2;
+    }
+
+    int half = size / 2;
+    taps[0] = index * 2;
+    taps[1] = index * 2 + 1;
+    taps[2] = index * 2 + 2;
+    weights[0] = float(half - index) / size;
+    weights[1] = float(half) / size;
+    weights[2] = float(index + 1) / size;
+    return 3;
+}
+}
+
+std::atomic<bool> RMipmapBuilder::m_enabled(false);
+
+/*static*/ void RMipmapBuilder::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+}
+
+/*static*/ bool RMipmapBuilder::isEnabled()
+{
+    return m_enabled;
+}
+
+/*static*/ RMipChain* RMipmapBuilder::build(const unsigned char *image, int width, int height,
+                                            unsigned owner, unsigned threads)
+{
+    REALIO_PROFILE_ZONE("RMipmapBuilder::build");
+
+    if(threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    RMipChain *chain = new RMipChain;
+
+    size_t size = 0;
+    int w = width, h = height;
+    while(w > 1 || h > 1)
+    {
+        RMipLevel level;
+        level.width = w = std::max(1, w / 2);
+        level.height = h = std::max(1, h / 2);
+        level.offset = size;
+
+        chain->levels.push_back(level);
+        size += (size_t)w * h * 4;
+    }
+    chain->pixels.resize(size);
+
+    const unsigned char *source = image;
+    w = width;
+    h = height;
+
+    for(unsigned i = 0; i < chain->levels.size(); ++i)
+    {
+        const RMipLevel &level = chain->levels[i];
+        unsigned char *result = chain->pixels.data() + level.offset;
+
+        unsigned slices = 1;
+        if(level.width * level.height >= PARALLEL_PIXELS)
+            slices = std::min<unsigned>(threads, level.height);
+
+        // The calling thread takes the first slice itself
+        std::vector<std::thread> workers;
+        for(unsigned j = 1; j < slices; ++j)
+            workers.push_back(std::thread(&RMipmapBuilder::downsample, source, w, h, result,
+                                          level.height * j / slices, level.height * (j + 1) / slices));
+
+        downsample(source, w, h, result, 0, level.height / slices);
+
+        for(unsigned j = 0; j < workers.size(); ++j)
+            workers[j].join();
+
+        source = result;
+        w = level.width;
+        h = level.height;
+    }
+
+    RMemoryTracker::allocate(MEMORY_DECODED_IMAGES, (uintptr_t)chain, chain->pixels.size(), owner);
+    return chain;
+}
+
+/*static*/ void RMipmapBuilder::destroy(RMipChain *chain)
+{
+    if(chain == nullptr)
+        return;
+
+    RMemoryTracker::release(MEMORY_DECODED_IMAGES, (uintptr_t)chain);
+    delete chain;
+}
+
+/*static*/ void RMipmapBuilder::upload(const RMipChain *chain)
+{
+    for(unsigned i = 0; i < chain->levels.size(); ++i)
+    {
+        const RMipLevel &level = chain->levels[i];
+        glTexImage2D(GL_TEXTURE_2D, i + 1, GL_RGBA, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                     chain->pixels.data() + level.offset);
+        RGLState::countTextureUpload(level.width * level.height * 4);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, chain->levels.size());
+}
+
+/*static*/ void RMipmapBuilder::downsample(const unsigned char *image, int width, int height, unsigned char *result,
+                                           int firstRow, int lastRow)
+{
+    const ColorTables &tables = colorTables();
+    const float *linear = tables.linear;
+
+    int w = std::max(1, width / 2);
+    int columns[3], rows[3];
+    float columnWeights[3], rowWeights[3];
+
+    for(int y = firstRow; y < lastRow; ++y)
+    {
+        int rowTaps = filterTaps(height, y, rows, rowWeights);
+        unsigned char *out = result + (size_t)y * w * 4;
+
+        for(int x = 0; x < w; ++x)
+        {
+            int columnTaps = filterTaps(width, x, columns, columnWeights);
+            int color[4];
+
+#ifdef __SSE2__
+            // One pixel per register: linear RGB from the table, alpha as is
+            __m128 sum = _mm_setzero_ps();
+            for(int i = 0; i < rowTaps; ++i)
+            {
+                const unsigned char *row = image + (size_t)rows[i] * width * 4;
+                for(int j = 0; j < columnTaps; ++j)
+                {
+                    const unsigned char *p = row + columns[j] * 4;
+                    __m128 pixel = _mm_set_ps(p[3], linear[p[2]], linear[p[1]], linear[p[0]]);
+                    sum = _mm_add_ps(sum, _mm_mul_ps(pixel, _mm_set1_ps(rowWeights[i] * columnWeights[j])));
+                }
+            }
+
+            const __m128 scale = _mm_set_ps(1.0f, LINEAR_STEPS - 1, LINEAR_STEPS - 1, LINEAR_STEPS - 1);
+            __m128i rounded = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(sum, scale), _mm_set1_ps(0.5f)));
+            _mm_storeu_si128((__m128i*)color, rounded);
+#else
+            float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            for(int i = 0; i < rowTaps; ++i)
+            {
+                const unsigned char *row = image + (size_t)rows[i] * width * 4;
+                for(int j = 0; j < columnTaps; ++j)
+                {
+                    const unsigned char *p = row + columns[j] * 4;
+                    float weight = rowWeights[i] * columnWeights[j];
+                    for(int c = 0; c < 3; ++c)
+                        sum[c] += linear[p[c]] * weight;
+                    sum[3] += p[3] * weight;
+                }
+            }
+
+            for(int c = 0; c < 3; ++c)
+                color[c] = (int)(sum[c] * (LINEAR_STEPS - 1) + 0.5f);
+            color[3] = (int)(sum[3] + 0.5f);
+#endif
+
+            // Weights may add up to a hair above one
+            out[x * 4] = tables.srgb[std::min(color[0], LINEAR_STEPS - 1)];
+            out[x * 4 + 1] = tables.srgb[std::min(color[1], LINEAR_STEPS - 1)];
+            out[x * 4 + 2] = tables.srgb[std::min(color[2], LINEAR_STEPS - 1)];
+            out[x * 4 + 3] = std::min(color[3], 255);
+        }
+    }
+}
+}
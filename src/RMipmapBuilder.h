@@ -0,0 +1,101 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RMIPMAPBUILDER_H
+#define RMIPMAPBUILDER_H
+
+//C++
+#include <atomic>
+#include <cstddef>
+#include <vector>
+//GLEW
+#include <GL/glew.h>
+
+namespace Realio {
+struct RMipLevel
+{
+    int width, height;
+    // Offset of the level's first pixel in the chain's pixels
+    size_t offset;
+};
+
+struct RMipChain
+{
+    // RGBA levels after the base one, down to 1x1
+    std::vector<unsigned char> pixels;
+    std::vector<RMipLevel> levels;
+};
+
+class RMipmapBuilder
+{
+public:
+    /**
+     * @brief makes loaders build mipmaps on the CPU, while they decode,
+     * instead of calling glGenerateMipmap on the rendering thread. It's off by default.
+     * @param true to build mipmaps on the CPU, false to let the driver do it.
+     * @return void.
+     */
+    static void setEnabled(bool enabled);
+
+    /**
+     * @brief returns true, if mipmaps are built on the CPU.
+     * @param void.
+     * @return true, if it's on. false, if not.
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief builds the whole mip chain of an RGBA image. Colors are averaged
+     * in linear light, as the image is sRGB, and alpha as is. Big levels are
+     * split between threads.
+     * @param image, its size, widget owning the memory (0 for the engine) and
+     * number of threads, 0 for one per core.
+     * @return new chain, which is freed with destroy().
+     */
+    static RMipChain* build(const unsigned char *image, int width, int height,
+                            unsigned owner = 0, unsigned threads = 0);
+
+    /**
+     * @brief frees the chain.
+     * @param chain, may be nullptr.
+     * @return void.
+     */
+    static void destroy(RMipChain *chain);
+
+    /**
+     * @brief uploads the chain to the bound texture as its levels from 1 on.
+     * The caller sets a mipmapped min filter like for generated levels.
+     * @param chain.
+     * @return void.
+     */
+    static void upload(const RMipChain *chain);
+
+    /**
+     * @brief halves rows of an RGBA image with a gamma-correct box filter.
+     * Odd sizes are filtered with three overlapping taps, so every source pixel counts.
+     * @param image, its size, place for the result of size max(1, w / 2) x max(1, h / 2)
+     * and the result's rows to fill, [firstRow, lastRow).
+     * @return void.
+     */
+    static void downsample(const unsigned char *image, int width, int height, unsigned char *result,
+                           int firstRow, int lastRow);
+
+private:
+    static std::atomic<bool> m_enabled;
+};
+}
+
+#endif // RMIPMAPBUILDER_H
@@ -17,8 +17,16 @@
 //Realio
 #include "RPixmap.h"
 #include "RCamera.h"
+#include "RGLState.h"
+#include "RImageLoader.h"
+#include "RMemoryTracker.h"
+#include "RMipmapBuilder.h"
+#include "RProfiler.h"
+#include "RRenderQueue.h"
+#include "RTextureCache.h"
+#include "RTextureFile.h"
+#include "RSpriteBatch.h"
 //C++
-#include <iostream>
 //STB
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb/stb_image.h"
@@ -32,6 +40,13 @@ RPixmap::RPixmap(
     : RWidget(x,y,w,h)
 {
     imgLoaded = false;
+    m_atlased = false;
+    m_texture = 0;
+    m_uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    m_placeholder = false;
+    m_shown = false;
+    m_loadTicket = 0;
+    m_cached = nullptr;
 }
 
 RPixmap::RPixmap(
@@ -40,147 +55,354 @@ RPixmap::RPixmap(
     : RWidget(x,y,0,0)
 {
     imgLoaded = false;
+    m_atlased = false;
+    m_texture = 0;
+    m_uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    m_placeholder = false;
+    m_shown = false;
+    m_loadTicket = 0;
+    m_cached = nullptr;
 }
 
 RPixmap::RPixmap()
     : RWidget(0,0,0,0)
 {
     imgLoaded = false;
+    m_atlased = false;
+    m_texture = 0;
+    m_uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    m_placeholder = false;
+    m_shown = false;
+    m_loadTicket = 0;
+    m_cached = nullptr;
 }
 
 RPixmap::~RPixmap()
 {
-    if(imgLoaded)
-        stbi_image_free(m_image);
+    if(m_loadTicket)
+        RImageLoader::cancel(m_loadTicket);
 
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
+    dropTexture();
+    releaseCached();
 }
 
 bool RPixmap::loadFile(const char *file)
 {
+    // A synchronous load wins over an unfinished asynchronous one
+    if(m_loadTicket)
+    {
+        RImageLoader::cancel(m_loadTicket);
+        m_loadTicket = 0;
+    }
+
     imgLoaded = false;
-    m_image = stbi_load(file, &img_width, &img_height, &comp, STBI_rgb_alpha);
 
-    if(!m_image)
-    {
-        std::cerr << "Could not load image '" << file << "' to RPixmap: ";
-        std::cerr << stbi_failure_reason() << std::endl;
+    // The same file is decoded and uploaded once for all pixmaps
+    RCachedTexture *entry = RTextureCache::acquire(file, this);
+    releaseCached();
+
+    if(entry == nullptr)
         return imgLoaded;
+
+    m_cached = entry;
+    setImage(entry->width, entry->height);
+
+    return imgLoaded;
+}
+
+std::shared_future<bool> RPixmap::loadFileAsync(const char *file,
+                                                void (*callback)(RPixmap *pixmap, bool loaded))
+{
+    if(m_loadTicket)
+        RImageLoader::cancel(m_loadTicket);
+
+    // A cached file is there already and a texture file is only mapped,
+    // so there is nothing to decode on the loader's threads
+    RCachedTexture *entry = RTextureCache::find(file, this);
+    if(entry == nullptr && RTextureFile::isTextureFile(file))
+        entry = RTextureCache::acquire(file, this);
+    if(entry != nullptr)
+    {
+        m_loadTicket = 0;
+        releaseCached();
+
+        m_cached = entry;
+        setImage(entry->width, entry->height);
+        if(m_shown)
+            show();
+
+        if(callback != nullptr)
+            callback(this, true);
+
+        std::promise<bool> loaded;
+        loaded.set_value(true);
+        return loaded.get_future().share();
     }
-    else
+
+    // Pixmaps loading the file meanwhile wait for the same image
+    std::shared_future<bool> loaded = RImageLoader::request(this, file, callback, m_loadTicket, true);
+
+    // Draw something meanwhile, unless there is an older image
+    if(!m_texture)
+    {
+        m_texture = RImageLoader::getPlaceholder();
+        m_placeholder = true;
+
         imgLoaded = true;
+        m_textured = true;
+        m_colored = false;
+        markDirty();
+    }
+
+    return loaded;
+}
+
+bool RPixmap::isLoading()
+{
+    return m_loadTicket != 0;
+}
+
+/*virtual*/ void RPixmap::imageDecoded(unsigned ticket, unsigned char *image, RMipChain *mips,
+                                       int width, int height, int components)
+{
+    // Requests of RPixmap are shared and come to imageCached(), so an image
+    // here has nowhere to go
+    (void)ticket;
+    (void)width;
+    (void)height;
+    (void)components;
+
+    if(image)
+    {
+        RMemoryTracker::release(MEMORY_DECODED_IMAGES, (uintptr_t)image);
+        stbi_image_free(image);
+    }
+    RMipmapBuilder::destroy(mips);
+}
+
+/*virtual*/ void RPixmap::imageCached(unsigned ticket, RCachedTexture *entry)
+{
+    (void)ticket;
+    m_loadTicket = 0;
+
+    if(entry == nullptr)
+    {
+        if(m_placeholder)
+        {
+            m_texture = 0;
+            m_placeholder = false;
+            imgLoaded = false;
+            markDirty();
+        }
+        return;
+    }
+
+    releaseCached();
+    m_cached = entry;
+    setImage(entry->width, entry->height);
+
+    if(m_shown)
+        show();
+}
+
+/*virtual*/ void RPixmap::textureUploaded(unsigned ticket, GLuint texture)
+{
+    (void)ticket;
+
+    dropTexture();
+
+    // The whole texture replaces the atlas region
+    if(m_atlased)
+    {
+        m_atlased = false;
+        m_uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    }
+
+    m_texture = texture;
+    m_placeholder = false;
+    markDirty();
+}
+
+void RPixmap::setImage(int width, int height)
+{
+    img_width = width;
+    img_height = height;
+    // Images are always decoded to RGBA
+    comp = 4;
+    imgLoaded = true;
+
+    // The new image replaces the atlas region, the page isn't the pixmap's
+    if(m_atlased)
+    {
+        m_texture = 0;
+        m_atlased = false;
+        m_uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    }
 
     if(!m_height && !m_width)
     {
         m_height = img_height;
         m_width = img_width;
+        m_resized = true;
     }
 
     m_textured = true;
     m_colored = false;
-
-    return imgLoaded;
 }
 
 /*virtual*/ void RPixmap::show()
 {
+    m_shown = true;
+
     if(!imgLoaded)
         return;
 
-    createShaders();
-    initializeVertices();
-
-    glGenTextures(1, &m_texture);
-    glBindTexture(GL_TEXTURE_2D, m_texture);
+    REALIO_PROFILE_ZONE("RPixmap::show");
 
-    // Set texture parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    // Set texture filtering
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    createShaders();
+    markDirty();
 
-    //Create texture
-    if(comp == 3)
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_width, m_height, 0, GL_RGB, GL_UNSIGNED_BYTE, m_image);
-    else if(comp == 4)
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_image);
+    // The atlas has the pixels, the image isn't needed anymore
+    if(m_atlased)
+    {
+        releaseCached();
+        update();
+        return;
+    }
 
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // The first pixmap of the file uploads it for everyone
+    if(m_cached != nullptr)
+    {
+        RTextureCache::upload(m_cached, this);
+        if(m_cached->texture && m_texture != m_cached->texture)
+        {
+            dropTexture();
+            m_texture = m_cached->texture;
+            m_placeholder = false;
+        }
+    }
 
     update();
 }
 
 /*virtual*/ void RPixmap::update()
 {
-    if(!imgLoaded)
+    if(!imgLoaded || !m_texture || !m_quad)
         return;
 
     // Activate shader
     m_shader->use();
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, m_texture);
-    glUniform1i(glGetUniformLocation(m_shader->getProgram(), "Texture"), 0);
-
-    glm::mat4 view;
-    glm::mat4 projection;
+    RGLState::bindTexture(m_texture);
+    m_shader->setInt(UNIFORM_TEXTURE, 0);
+    m_shader->setVec4(UNIFORM_UV_RECT, m_uvRect);
 
-    // Pass the matrices to the shader
-    glUniformMatrix4fv(glGetUniformLocation(m_shader->getProgram(), "model"), 1, GL_FALSE, glm::value_ptr(m_modelMatrix));
-    glUniformMatrix4fv(glGetUniformLocation(m_shader->getProgram(), "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(m_shader->getProgram(), "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    // View and projection are shared through the camera's uniform block
+    m_shader->setMat4(UNIFORM_MODEL, getTransform());
 
     // Draw container
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    m_quad->draw();
 }
 
-void RPixmap::initializeVertices()
+/*virtual*/ void RPixmap::submit(RSpriteBatch *batch)
 {
-    if(!imgLoaded)
+    if(!imgLoaded || !m_texture)
         return;
 
-    float width = float(2 * m_width) / float(m_winWidth);
-    float height = float(2 * m_height) / float(m_winHeight);
+    batch->draw(m_shader, m_texture, getTransform(), m_uvRect);
+}
+
+/*virtual*/ void RPixmap::enqueue(RRenderQueue *queue)
+{
+    if(!imgLoaded || !m_texture)
+        return;
+
+    queue->push(this, m_layer, m_shader->getProgram(), m_texture);
+}
+
+/*virtual*/ void RPixmap::keepResident()
+{
+    if(m_cached == nullptr || m_atlased || !m_shown)
+        return;
+
+    RTextureCache::touch(m_cached);
+
+    // The texture was evicted, while the pixmap was off the screen
+    if(!m_cached->texture)
+        RTextureCache::upload(m_cached, this);
+
+    if(m_cached->texture && m_texture != m_cached->texture)
+    {
+        dropTexture();
+        m_texture = m_cached->texture;
+        m_placeholder = false;
+        markDirty();
+    }
+}
+
+const unsigned char* RPixmap::getImage()
+{
+    return m_cached != nullptr ? m_cached->image : nullptr;
+}
+
+int RPixmap::getImageWidth()
+{
+    return img_width;
+}
+
+int RPixmap::getImageHeight()
+{
+    return img_height;
+}
+
+bool RPixmap::isAtlased()
+{
+    return m_atlased;
+}
+
+const glm::vec4& RPixmap::getUvRect()
+{
+    return m_uvRect;
+}
 
-    GLfloat vertices[] = {
-        // Positions                      // Texture Coords
-        -1.0f+width,  1.0f,        0.0f,   1.0f, 1.0f, // Top Right
-        -1.0f+width,  1.0f-height, 0.0f,   1.0f, 0.0f, // Bottom Right
-        -1.0f,        1.0f-height, 0.0f,   0.0f, 0.0f, // Bottom Left
-        -1.0f,        1.0f,        0.0f,   0.0f, 1.0f  // Top Left
-    };
+void RPixmap::setAtlasRegion(GLuint texture, const glm::vec4 &uvRect)
+{
+    dropTexture();
 
-    GLuint indices[] = {
-        0, 1, 3,
-        1, 2, 3
-    };
+    m_texture = texture;
+    m_placeholder = false;
+    m_uvRect = uvRect;
+    m_atlased = true;
+    markDirty();
+}
 
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+bool RPixmap::ownsTexture()
+{
+    // Atlas pages belong to the atlas, the placeholder to the loader
+    if(!m_texture || m_atlased || m_placeholder)
+        return false;
 
-    glBindVertexArray(VAO);
+    return m_cached == nullptr || m_texture != m_cached->texture;
+}
+
+void RPixmap::dropTexture()
+{
+    if(ownsTexture())
+        RGLState::deleteTexture(m_texture);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    m_texture = 0;
+}
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+void RPixmap::releaseCached()
+{
+    if(m_cached == nullptr)
+        return;
 
-    // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)0);
-    glEnableVertexAttribArray(0);
-    // Texture attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(1);
+    if(m_texture == m_cached->texture)
+        m_texture = 0;
 
-    glBindVertexArray(0); // Unbind VAO
+    RTextureCache::release(m_cached, this);
+    m_cached = nullptr;
 }
 
 void RPixmap::fitByImage()
@@ -190,5 +412,6 @@ void RPixmap::fitByImage()
 
     m_width = img_width;
     m_height = img_height;
+    m_resized = true;
 }
 }
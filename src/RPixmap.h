@@ -19,8 +19,13 @@
 
 //Realio
 #include "RWidget.h"
+//C++
+#include <future>
 
 namespace Realio {
+struct RCachedTexture;
+struct RMipChain;
+
 class RPixmap : public RWidget
 {
 public:
@@ -30,12 +35,34 @@ public:
     ~RPixmap();
 
     /**
-     * @brief loads the image into the widget.
+     * @brief loads the image into the widget. Files are shared through
+     * RTextureCache, so pixmaps of one file decode and upload it once.
+     * Texture files written by realio_texconv are mapped with their mipmaps.
+     * Files in a mounted RAssetPack are taken from there, others from the disk.
      * @param const char array.
      * @return True, if file is successfully loaded. False, if not.
      */
     bool loadFile(const char *file);
 
+    /**
+     * @brief starts decoding the image on RImageLoader's threads and returns
+     * at once. Until the image comes, the pixmap draws a placeholder. A file
+     * already in RTextureCache or a texture file is taken from there at once.
+     * Pixmaps loading one file meanwhile share its decode and its cache entry.
+     * @param path to the file and function called on the rendering thread,
+     * when the image is loaded or failed (may be nullptr).
+     * @return future, which is true if the image is loaded.
+     */
+    std::shared_future<bool> loadFileAsync(const char *file,
+                                           void (*callback)(RPixmap *pixmap, bool loaded) = nullptr);
+
+    /**
+     * @brief returns true, if an asynchronous load isn't finished yet.
+     * @param void.
+     * @return true, if the image is loading. false, if not.
+     */
+    bool isLoading();
+
     /**
      * @brief shows up the pixmap to the widget.
      * @param void.
@@ -50,6 +77,27 @@ public:
      */
     virtual void update();
 
+    /**
+     * @brief queues the pixmap's quad to the sprite batch.
+     * @param pointer to the window's sprite batch.
+     * @return void.
+     */
+    virtual void submit(RSpriteBatch *batch);
+
+    /**
+     * @brief submits the pixmap to the render queue, unless it has nothing to draw.
+     * @param pointer to the window's render queue.
+     * @return void.
+     */
+    virtual void enqueue(RRenderQueue *queue);
+
+    /**
+     * @brief keeps the cached texture from eviction and reloads it, if it's evicted.
+     * @param void.
+     * @return void.
+     */
+    virtual void keepResident();
+
     /**
      * @brief sets the widget's width and height to the image's ones.
      * @param void.
@@ -57,22 +105,123 @@ public:
      */
     void fitByImage();
 
+    /**
+     * @brief returns the decoded image (RGBA, 8 bits per channel). The image
+     * is shared through RTextureCache and freed, once it's uploaded.
+     * @param void.
+     * @return pointer to pixels, nullptr if no image is loaded or it's uploaded.
+     */
+    const unsigned char* getImage();
+
+    /**
+     * @brief returns width of the loaded image.
+     * @param void.
+     * @return image's width in pixels.
+     */
+    int getImageWidth();
+
+    /**
+     * @brief returns height of the loaded image.
+     * @param void.
+     * @return image's height in pixels.
+     */
+    int getImageHeight();
+
+    /**
+     * @brief makes the pixmap draw a region of a shared texture instead
+     * of creating its own one in show().
+     * @param texture and region's corners (left, top, right, bottom) in texture coordinates.
+     * @return void.
+     */
+    void setAtlasRegion(GLuint texture, const glm::vec4 &uvRect);
+
+    /**
+     * @brief returns true, if the pixmap draws a region of an atlas page.
+     * Loading another image makes it draw its own texture again.
+     * @param void.
+     * @return true, if the pixmap is atlased. false, if not.
+     */
+    bool isAtlased();
+
+    /**
+     * @brief returns the region of the texture the pixmap draws.
+     * @param void.
+     * @return corners (left, top, right, bottom) in texture coordinates.
+     */
+    const glm::vec4& getUvRect();
+
 protected:
+    friend class RImageLoader;
+    friend class RTextureCache;
+    friend class RTextureUploader;
+
     bool imgLoaded;
+    bool m_atlased;
 
     GLuint m_texture;
-    GLuint VBO, VAO, EBO;
+    glm::vec4 m_uvRect;
+    // True, if m_texture is RImageLoader's placeholder
+    bool m_placeholder;
+    // True, once show() is called, so loaded images are shown at once
+    bool m_shown;
 
     /**
-     * @brief initializes the widget's size and position.
-     * @param void.
+     * @brief takes the image decoded by RImageLoader for a request, which isn't shared.
+     * RPixmap doesn't make such requests, so it frees the image.
+     * @param ticket of the request, image (nullptr if it failed), its mipmaps
+     * (nullptr if the GPU generates them) and its size.
+     * @return void.
+     */
+    virtual void imageDecoded(unsigned ticket, unsigned char *image, RMipChain *mips,
+                              int width, int height, int comp);
+
+    /**
+     * @brief takes the cached image of a shared RImageLoader request and draws it.
+     * @param ticket of the request and the entry with the pixmap's reference (nullptr if it failed).
+     * @return void.
+     */
+    virtual void imageCached(unsigned ticket, RCachedTexture *entry);
+
+    /**
+     * @brief takes the texture streamed by RTextureUploader and starts drawing it.
+     * @param ticket of the upload and the complete texture.
      * @return void.
      */
-    void initializeVertices();
+    virtual void textureUploaded(unsigned ticket, GLuint texture);
 
 private:
-    unsigned char *m_image;
     int img_height, img_width, comp;
+    unsigned m_loadTicket;
+    // Shared image and texture of the loaded file
+    RCachedTexture *m_cached;
+
+    /**
+     * @brief takes the size of the cached image and fits the widget to it.
+     * @param image's size.
+     * @return void.
+     */
+    void setImage(int width, int height);
+
+    /**
+     * @brief returns true, if m_texture is the pixmap's own and must be deleted by it.
+     * @param void.
+     * @return true, if the texture is owned. false, if it's shared.
+     */
+    bool ownsTexture();
+
+    /**
+     * @brief deletes the texture, if it's owned, and forgets it.
+     * @param void.
+     * @return void.
+     */
+    void dropTexture();
+
+    /**
+     * @brief drops the reference to the cached file.
+     * @param void.
+     * @return void.
+     */
+    void releaseCached();
 };
 }
 
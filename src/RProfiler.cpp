@@ -0,0 +1,202 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RProfiler.h"
+//C++
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace Realio {
+#ifdef REALIO_PROFILING
+namespace {
+struct Zone {
+    const char *name;
+    uint64_t begin, end;
+};
+
+struct ThreadRing {
+    std::mutex mutex;
+    std::vector<Zone> zones;
+    unsigned next;
+    bool wrapped;
+    unsigned thread;
+};
+
+std::atomic<bool> enabled(true);
+
+// Rings outlive their threads, so zones of finished threads can be written
+std::mutex registryMutex;
+std::vector<ThreadRing*> registry;
+
+thread_local ThreadRing *threadRing = nullptr;
+
+ThreadRing* currentRing()
+{
+    if(threadRing == nullptr)
+    {
+        threadRing = new ThreadRing;
+        threadRing->zones.resize(RProfiler::RING_SIZE);
+        threadRing->next = 0;
+        threadRing->wrapped = false;
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        threadRing->thread = registry.size() + 1;
+        registry.push_back(threadRing);
+    }
+
+    return threadRing;
+}
+
+void writeEscaped(std::ostream &out, const char *text)
+{
+    for(; *text; ++text)
+    {
+        if(*text == '"' || *text == '\\')
+            out << '\\';
+        out << *text;
+    }
+}
+}
+#endif
+
+/*static*/ void RProfiler::setEnabled(bool enabled)
+{
+#ifdef REALIO_PROFILING
+    Realio::enabled = enabled;
+#else
+    (void)enabled;
+#endif
+}
+
+/*static*/ bool RProfiler::isEnabled()
+{
+#ifdef REALIO_PROFILING
+    return enabled;
+#else
+    return false;
+#endif
+}
+
+/*static*/ void RProfiler::clear()
+{
+#ifdef REALIO_PROFILING
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for(unsigned i = 0; i < registry.size(); ++i)
+    {
+        std::lock_guard<std::mutex> ringLock(registry[i]->mutex);
+        registry[i]->next = 0;
+        registry[i]->wrapped = false;
+    }
+#endif
+}
+
+/*static*/ bool RProfiler::writeTrace(const std::string &path)
+{
+#ifdef REALIO_PROFILING
+    std::ofstream file(path.c_str());
+    if(!file)
+    {
+        std::cerr << "Could not write trace to '" << path << "'" << std::endl;
+        return false;
+    }
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    file.precision(3);
+    file << std::fixed;
+
+    bool first = true;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for(unsigned i = 0; i < registry.size(); ++i)
+    {
+        ThreadRing *ring = registry[i];
+        std::lock_guard<std::mutex> ringLock(ring->mutex);
+
+        // Oldest zones first
+        unsigned count = ring->wrapped ? RING_SIZE : ring->next;
+        unsigned start = ring->wrapped ? ring->next : 0;
+
+        for(unsigned j = 0; j < count; ++j)
+        {
+            const Zone &zone = ring->zones[(start + j) % RING_SIZE];
+
+            file << (first ? "\n" : ",\n") << "{\"name\":\"";
+            writeEscaped(file, zone.name);
+            file << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->thread <<
+                    ",\"ts\":" << zone.begin / 1000.0 <<
+                    ",\"dur\":" << (zone.end - zone.begin) / 1000.0 << "}";
+            first = false;
+        }
+    }
+
+    file << "\n]}\n";
+    return true;
+#else
+    std::cerr << "Could not write trace to '" << path << "': " <<
+                 "Realio is built without REALIO_PROFILING" << std::endl;
+    return false;
+#endif
+}
+
+/*static*/ void RProfiler::record(const char *name, uint64_t begin, uint64_t end)
+{
+#ifdef REALIO_PROFILING
+    if(!enabled)
+        return;
+
+    ThreadRing *ring = currentRing();
+
+    // Only the writer of the trace competes for the lock
+    std::lock_guard<std::mutex> lock(ring->mutex);
+    Zone &zone = ring->zones[ring->next];
+    zone.name = name;
+    zone.begin = begin;
+    zone.end = end;
+
+    if(++ring->next == RING_SIZE)
+    {
+        ring->next = 0;
+        ring->wrapped = true;
+    }
+#else
+    (void)name;
+    (void)begin;
+    (void)end;
+#endif
+}
+
+/*static*/ uint64_t RProfiler::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+RProfileZone::RProfileZone(const char *name)
+{
+    m_name = name;
+    m_begin = RProfiler::now();
+}
+
+RProfileZone::~RProfileZone()
+{
+    RProfiler::record(m_name, m_begin, RProfiler::now());
+}
+}
@@ -0,0 +1,97 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RPROFILER_H
+#define RPROFILER_H
+
+//C++
+#include <cstdint>
+#include <string>
+
+namespace Realio {
+class RProfiler
+{
+public:
+    /**
+     * @brief enables or disables recording of zones. Recording is enabled by default.
+     * @param true to record zones, false to ignore them.
+     * @return void.
+     */
+    static void setEnabled(bool enabled);
+
+    /**
+     * @brief returns true if zones are recorded.
+     * @param void.
+     * @return true, if the profiler is compiled in and enabled. false, if not.
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief forgets recorded zones of all threads.
+     * @param void.
+     * @return void.
+     */
+    static void clear();
+
+    /**
+     * @brief writes zones kept in the threads' rings as Chrome trace JSON,
+     * which about:tracing and Perfetto open.
+     * @param path to the file.
+     * @return true, if the file is written. false, if not.
+     */
+    static bool writeTrace(const std::string &path);
+
+    /**
+     * @brief adds a finished zone to the calling thread's ring.
+     * @param name of the zone, which must outlive the profiler, and its bounds.
+     * @return void.
+     */
+    static void record(const char *name, uint64_t begin, uint64_t end);
+
+    /**
+     * @brief returns the profiler's clock.
+     * @param void.
+     * @return nanoseconds from an arbitrary point.
+     */
+    static uint64_t now();
+
+    // Zones kept per thread, older ones are overwritten
+    static const unsigned RING_SIZE = 65536;
+};
+
+class RProfileZone
+{
+public:
+    explicit RProfileZone(const char *name);
+    ~RProfileZone();
+
+private:
+    const char *m_name;
+    uint64_t m_begin;
+};
+}
+
+// Zones exist only in builds with REALIO_PROFILING, others don't pay for them
+#ifdef REALIO_PROFILING
+#define REALIO_PROFILE_CONCAT_(a, b) a##b
+#define REALIO_PROFILE_CONCAT(a, b) REALIO_PROFILE_CONCAT_(a, b)
+#define REALIO_PROFILE_ZONE(name) \
+    Realio::RProfileZone REALIO_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define REALIO_PROFILE_ZONE(name)
+#endif
+
+#endif // RPROFILER_H
@@ -0,0 +1,91 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RQuad.h"
+#include "RGLState.h"
+#include "RMemoryTracker.h"
+
+namespace Realio {
+const GLfloat RQuad::vertices[20] = {
+    // Positions          // Texture Coords
+    1.0f, 1.0f, 0.0f,     1.0f, 1.0f, // Top Right
+    1.0f, 0.0f, 0.0f,     1.0f, 0.0f, // Bottom Right
+    0.0f, 0.0f, 0.0f,     0.0f, 0.0f, // Bottom Left
+    0.0f, 1.0f, 0.0f,     0.0f, 1.0f  // Top Left
+};
+
+const GLuint RQuad::indices[6] = {
+    0, 1, 3,
+    1, 2, 3
+};
+
+RQuad::RQuad()
+{
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+
+    RGLState::bindVertexArray(VAO);
+
+    RGLState::bindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+    RMemoryTracker::allocate(MEMORY_BUFFERS, VBO, sizeof(vertices));
+    RMemoryTracker::allocate(MEMORY_BUFFERS, EBO, sizeof(indices));
+
+    // Position attribute
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)0);
+    glEnableVertexAttribArray(0);
+    // Texture attribute
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(1);
+
+    RGLState::bindVertexArray(0); // Unbind VAO
+}
+
+RQuad::~RQuad()
+{
+    RGLState::deleteVertexArray(VAO);
+    RGLState::deleteBuffer(VBO);
+    RGLState::deleteBuffer(EBO);
+}
+
+void RQuad::draw()
+{
+    RGLState::bindVertexArray(VAO);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    RGLState::countDraw(2);
+}
+
+GLuint RQuad::getVertexArray()
+{
+    return VAO;
+}
+
+GLuint RQuad::getVertexBuffer()
+{
+    return VBO;
+}
+
+GLuint RQuad::getIndexBuffer()
+{
+    return EBO;
+}
+}
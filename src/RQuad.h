@@ -0,0 +1,67 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RQUAD_H
+#define RQUAD_H
+
+//GLEW
+#include <GL/glew.h>
+
+namespace Realio {
+class RQuad
+{
+public:
+    RQuad();
+    ~RQuad();
+
+    /**
+     * @brief draws the quad with the current program.
+     * @param void.
+     * @return void.
+     */
+    void draw();
+
+    /**
+     * @brief returns the quad's vertex array.
+     * @param void.
+     * @return VAO, placed in GLuint.
+     */
+    GLuint getVertexArray();
+
+    /**
+     * @brief returns the quad's vertex buffer.
+     * @param void.
+     * @return VBO, placed in GLuint.
+     */
+    GLuint getVertexBuffer();
+
+    /**
+     * @brief returns the quad's index buffer.
+     * @param void.
+     * @return EBO, placed in GLuint.
+     */
+    GLuint getIndexBuffer();
+
+    // Unit quad's vertices (x, y, z, u, v). Texture coordinates match positions.
+    static const GLfloat vertices[20];
+    static const GLuint indices[6];
+
+private:
+    GLuint VBO, VAO, EBO;
+};
+}
+
+#endif // RQUAD_H
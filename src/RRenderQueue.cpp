@@ -0,0 +1,185 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RRenderQueue.h"
+#include "RProfiler.h"
+//C++
+#include <algorithm>
+
+namespace Realio {
+namespace {
+const unsigned LAYER_SHIFT = 56;
+const unsigned SLOT_SHIFT = 40;
+const unsigned PROGRAM_SHIFT = 24;
+const uint64_t MAX_SLOT = 0xFFFF;
+// Overlaps are found on a grid of cells, sharing a cell counts as overlapping
+const int CELL_SIZE = 64;
+const int MAX_CELLS = 128;
+}
+
+RRenderQueue::RRenderQueue()
+{
+
+}
+
+RRenderQueue::~RRenderQueue()
+{
+
+}
+
+void RRenderQueue::clear()
+{
+    m_items.clear();
+}
+
+void RRenderQueue::push(RWidget *widget, int layer, GLuint program, GLuint texture)
+{
+    // Key layout, from the highest bit: layer:8 | slot:16 | program:16 | texture:24.
+    // The slot is filled in by sort(); equal keys keep their order
+    uint64_t key = uint64_t(std::min(std::max(layer + 128, 0), 255)) << LAYER_SHIFT;
+    key |= uint64_t(program & 0xFFFF) << PROGRAM_SHIFT;
+    key |= uint64_t(texture & 0xFFFFFF);
+
+    Item item;
+    item.key = key;
+    item.widget = widget;
+    m_items.push_back(item);
+}
+
+void RRenderQueue::sort(const std::map<RWidget*, SDL_Rect> &bounds)
+{
+    REALIO_PROFILE_ZONE("RRenderQueue::sort");
+
+    size_t count = m_items.size();
+    if(count < 2)
+        return;
+
+    // The grid covers everything drawn, offscreen parts fall into the edge cells
+    int right = 0, bottom = 0;
+    bool layers[256] = {false};
+    for(size_t i = 0; i < count; ++i)
+    {
+        std::map<RWidget*, SDL_Rect>::const_iterator rect = bounds.find(m_items[i].widget);
+        if(rect != bounds.end())
+        {
+            right = std::max(right, rect->second.x + rect->second.w);
+            bottom = std::max(bottom, rect->second.y + rect->second.h);
+        }
+        layers[m_items[i].key >> LAYER_SHIFT] = true;
+    }
+
+    int columns = std::min(std::max(right, 1) / CELL_SIZE + 1, MAX_CELLS);
+    int rows = std::min(std::max(bottom, 1) / CELL_SIZE + 1, MAX_CELLS);
+
+    for(unsigned layer = 0; layer < 256; ++layer)
+        if(layers[layer])
+            assignSlots(layer, bounds, columns, rows);
+
+    m_scratch.resize(count);
+    Item *src = m_items.data();
+    Item *dst = m_scratch.data();
+
+    // LSD radix sort, one byte per pass. It's stable, so equal keys keep their order.
+    for(unsigned shift = 0; shift < 64; shift += 8)
+    {
+        size_t offsets[256] = {0};
+
+        for(size_t i = 0; i < count; ++i)
+            offsets[(src[i].key >> shift) & 0xFF]++;
+
+        // Every key has the same byte here, nothing to do
+        if(offsets[(src[0].key >> shift) & 0xFF] == count)
+            continue;
+
+        size_t total = 0;
+        for(unsigned b = 0; b < 256; ++b)
+        {
+            size_t bucket = offsets[b];
+            offsets[b] = total;
+            total += bucket;
+        }
+
+        for(size_t i = 0; i < count; ++i)
+            dst[offsets[(src[i].key >> shift) & 0xFF]++] = src[i];
+
+        std::swap(src, dst);
+    }
+
+    if(src != m_items.data())
+        m_items.swap(m_scratch);
+}
+
+unsigned RRenderQueue::size()
+{
+    return m_items.size();
+}
+
+RWidget* RRenderQueue::getWidget(unsigned index)
+{
+    return m_items[index].widget;
+}
+
+uint64_t RRenderQueue::getKey(unsigned index)
+{
+    return m_items[index].key;
+}
+
+void RRenderQueue::assignSlots(unsigned layer, const std::map<RWidget*, SDL_Rect> &bounds,
+                               int columns, int rows)
+{
+    m_cells.assign(columns * rows, 0);
+
+    for(size_t i = 0; i < m_items.size(); ++i)
+    {
+        Item &item = m_items[i];
+        if(item.key >> LAYER_SHIFT != layer)
+            continue;
+
+        int left = 0, top = 0, right = columns - 1, bottom = rows - 1;
+        std::map<RWidget*, SDL_Rect>::const_iterator rect = bounds.find(item.widget);
+        if(rect != bounds.end())
+        {
+            // Empty rectangles draw nothing, they can go anywhere
+            if(rect->second.w <= 0 || rect->second.h <= 0)
+                continue;
+
+            left = std::min(std::max(rect->second.x / CELL_SIZE, 0), columns - 1);
+            top = std::min(std::max(rect->second.y / CELL_SIZE, 0), rows - 1);
+            right = std::min(std::max((rect->second.x + rect->second.w - 1) / CELL_SIZE, 0), columns - 1);
+            bottom = std::min(std::max((rect->second.y + rect->second.h - 1) / CELL_SIZE, 0), rows - 1);
+        }
+
+        uint64_t slot = 0;
+        for(int y = top; y <= bottom; ++y)
+            for(int x = left; x <= right; ++x)
+                slot = std::max(slot, uint64_t(m_cells[y * columns + x]) + 1);
+
+        // Out of slots, the rest of the layer keeps its order
+        if(slot >= MAX_SLOT)
+        {
+            slot = MAX_SLOT;
+            item.key &= ~((uint64_t(1) << SLOT_SHIFT) - 1);
+        }
+
+        for(int y = top; y <= bottom; ++y)
+            for(int x = left; x <= right; ++x)
+                m_cells[y * columns + x] = slot;
+
+        item.key |= slot << SLOT_SHIFT;
+    }
+}
+}
@@ -0,0 +1,104 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RRENDERQUEUE_H
+#define RRENDERQUEUE_H
+
+//C++
+#include <cstdint>
+#include <map>
+#include <vector>
+//SDL2
+#include <SDL2/SDL.h>
+//GLEW
+#include <GL/glew.h>
+
+namespace Realio {
+class RWidget;
+
+class RRenderQueue
+{
+public:
+    RRenderQueue();
+    ~RRenderQueue();
+
+    /**
+     * @brief removes all submitted items.
+     * @param void.
+     * @return void.
+     */
+    void clear();
+
+    /**
+     * @brief submits a drawable. Layers are drawn from the lowest one. Inside
+     * a layer items are grouped by program and texture, but an item never
+     * moves over one it overlaps and that was submitted before it.
+     * @param drawable, its layer (-128..127), program and texture (0 for none).
+     * @return void.
+     */
+    void push(RWidget *widget, int layer, GLuint program, GLuint texture);
+
+    /**
+     * @brief sorts submitted items by their keys with a radix sort. Every item
+     * gets the lowest slot above the items it overlaps, so items of a slot
+     * don't overlap and may be drawn in any order.
+     * @param screen rectangles of the items, an item without one overlaps everything.
+     * @return void.
+     */
+    void sort(const std::map<RWidget*, SDL_Rect> &bounds);
+
+    /**
+     * @brief returns number of submitted items.
+     * @param void.
+     * @return number of items.
+     */
+    unsigned size();
+
+    /**
+     * @brief returns the item's drawable.
+     * @param index of the item.
+     * @return pointer to the RWidget.
+     */
+    RWidget* getWidget(unsigned index);
+
+    /**
+     * @brief returns the item's sort key.
+     * @param index of the item.
+     * @return 64-bit key.
+     */
+    uint64_t getKey(unsigned index);
+
+private:
+    struct Item {
+        uint64_t key;
+        RWidget *widget;
+    };
+    std::vector<Item> m_items;
+    std::vector<Item> m_scratch;
+    // Highest slot drawn into every cell of the screen, one layer at a time
+    std::vector<uint16_t> m_cells;
+
+    /**
+     * @brief puts the slot of every item of the layer into its key.
+     * @param layer as in the key (0..255), the rectangles and grid size in cells.
+     * @return void.
+     */
+    void assignSlots(unsigned layer, const std::map<RWidget*, SDL_Rect> &bounds,
+                     int columns, int rows);
+};
+}
+
+#endif // RRENDERQUEUE_H
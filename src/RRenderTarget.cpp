@@ -0,0 +1,99 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RRenderTarget.h"
+#include "RMemoryTracker.h"
+//C++
+#include <iostream>
+
+namespace Realio {
+RRenderTarget::RRenderTarget(const int width, const int height)
+{
+    m_width = width;
+    m_height = height;
+
+    glGenFramebuffers(1, &FBO);
+    glGenRenderbuffers(1, &m_color);
+    glGenRenderbuffers(1, &m_depthStencil);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, m_color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_width, m_height);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depthStencil);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_width, m_height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    // Both formats take 4 bytes per pixel
+    RMemoryTracker::allocate(MEMORY_RENDER_TARGETS, m_color, m_width * m_height * 4);
+    RMemoryTracker::allocate(MEMORY_RENDER_TARGETS, m_depthStencil, m_width * m_height * 4);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthStencil);
+
+    m_complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if(!m_complete)
+        std::cerr << "Could not create " << m_width << "x" << m_height <<
+                     " framebuffer" << std::endl;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+RRenderTarget::~RRenderTarget()
+{
+    glDeleteFramebuffers(1, &FBO);
+    glDeleteRenderbuffers(1, &m_color);
+    glDeleteRenderbuffers(1, &m_depthStencil);
+
+    RMemoryTracker::release(MEMORY_RENDER_TARGETS, m_color);
+    RMemoryTracker::release(MEMORY_RENDER_TARGETS, m_depthStencil);
+}
+
+bool RRenderTarget::isComplete()
+{
+    return m_complete;
+}
+
+void RRenderTarget::bind()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    glViewport(0, 0, m_width, m_height);
+}
+
+void RRenderTarget::blit(const int width, const int height)
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, width, height,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+GLuint RRenderTarget::getFramebuffer()
+{
+    return FBO;
+}
+
+int RRenderTarget::getWidth()
+{
+    return m_width;
+}
+
+int RRenderTarget::getHeight()
+{
+    return m_height;
+}
+}
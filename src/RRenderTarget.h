@@ -0,0 +1,85 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RRENDERTARGET_H
+#define RRENDERTARGET_H
+
+//GLEW
+#include <GL/glew.h>
+
+namespace Realio {
+class RRenderTarget
+{
+public:
+    /**
+     * @brief creates a framebuffer with RGBA color and depth/stencil renderbuffers.
+     * @param width and height in pixels.
+     */
+    RRenderTarget(const int width, const int height);
+    ~RRenderTarget();
+
+    /**
+     * @brief returns true if the framebuffer can be drawn to.
+     * @param void.
+     * @return true, if the framebuffer is complete. false, if not.
+     */
+    bool isComplete();
+
+    /**
+     * @brief binds the framebuffer for drawing and reading and sets the viewport to it.
+     * @param void.
+     * @return void.
+     */
+    void bind();
+
+    /**
+     * @brief copies the framebuffer's color to the window's framebuffer
+     * and leaves the latter bound.
+     * @param size of the window's framebuffer.
+     * @return void.
+     */
+    void blit(const int width, const int height);
+
+    /**
+     * @brief returns the framebuffer.
+     * @param void.
+     * @return framebuffer, placed in GLuint.
+     */
+    GLuint getFramebuffer();
+
+    /**
+     * @brief returns width of the framebuffer.
+     * @param void.
+     * @return width in pixels.
+     */
+    int getWidth();
+
+    /**
+     * @brief returns height of the framebuffer.
+     * @param void.
+     * @return height in pixels.
+     */
+    int getHeight();
+
+private:
+    GLuint FBO, m_color, m_depthStencil;
+
+    int m_width, m_height;
+    bool m_complete;
+};
+}
+
+#endif // RRENDERTARGET_H
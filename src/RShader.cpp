@@ -16,27 +16,54 @@
 
 //Realio
 #include "RShader.h"
+#include "RCameraBuffer.h"
+#include "RGLState.h"
+#include "RMemoryTracker.h"
+#include "RProfiler.h"
 //C++
+#include <cstring>
 #include <iostream>
+//GLM
+#include <glm/gtc/type_ptr.hpp>
 
 namespace Realio {
+namespace {
+// Names of RShaderUniform values
+const char *standardUniforms[UNIFORM_COUNT] = {
+    "model",
+    "Texture",
+    "Color",
+    "uvRect"
+};
+}
+
 RShader::RShader()
 {
+    m_program = 0;
 
+    for(unsigned i = 0; i < UNIFORM_COUNT; ++i)
+        m_standardLocations[i] = -1;
 }
 
 RShader::RShader(const char *vShader, const char *fShader)
 {
+    m_program = 0;
+
+    for(unsigned i = 0; i < UNIFORM_COUNT; ++i)
+        m_standardLocations[i] = -1;
+
     compileShaders(vShader, fShader);
 }
 
 void RShader::use()
 {
-    glUseProgram(m_program);
+    RGLState::useProgram(m_program);
 }
 
 void RShader::compileShaders(const char *vShader, const char *fShader)
 {
+    REALIO_PROFILE_ZONE("RShader::compileShaders");
+
     // Compile shaders
     GLuint vertex, fragment;
     GLint success;
@@ -82,6 +109,149 @@ void RShader::compileShaders(const char *vShader, const char *fShader)
     // Delete the shaders as they're linked into our program now and no longer necessary
     glDeleteShader(vertex);
     glDeleteShader(fragment);
+
+    // Drivers don't tell the program's size, its binary is the closest guess
+    GLint size = 0;
+    if(GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+        glGetProgramiv(m_program, GL_PROGRAM_BINARY_LENGTH, &size);
+    if(size <= 0)
+        size = std::strlen(vShader) + std::strlen(fShader);
+    RMemoryTracker::allocate(MEMORY_PROGRAMS, m_program, size);
+
+    resolveUniforms();
+}
+
+void RShader::resolveUniforms()
+{
+    GLint count = 0, maxLength = 0;
+
+    m_locations.clear();
+    m_values.clear();
+
+    glGetProgramiv(m_program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<GLchar> name(maxLength + 1);
+    GLint maxLocation = -1;
+
+    for(GLint i = 0; i < count; ++i)
+    {
+        GLint size;
+        GLenum type;
+        glGetActiveUniform(m_program, i, name.size(), NULL, &size, &type, name.data());
+
+        GLint location = glGetUniformLocation(m_program, name.data());
+        // Members of uniform blocks have no locations
+        if(location < 0)
+            continue;
+
+        std::string uniform(name.data());
+        m_locations[uniform] = location;
+
+        // Arrays are reported as "name[0]"
+        if(uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0)
+            m_locations[uniform.substr(0, uniform.size() - 3)] = location;
+
+        if(location + size - 1 > maxLocation)
+            maxLocation = location + size - 1;
+    }
+
+    UniformValue empty;
+    std::memset(&empty, 0, sizeof(empty));
+    m_values.assign(maxLocation + 1, empty);
+
+    for(unsigned i = 0; i < UNIFORM_COUNT; ++i)
+        m_standardLocations[i] = getUniformLocation(standardUniforms[i]);
+
+    // View and projection come from the window's camera buffer
+    GLuint block = glGetUniformBlockIndex(m_program, RCameraBuffer::BLOCK_NAME);
+    if(block != GL_INVALID_INDEX)
+        glUniformBlockBinding(m_program, block, RCameraBuffer::BINDING);
+}
+
+RShader::UniformValue* RShader::getValue(const GLint location)
+{
+    if(location < 0 || location >= GLint(m_values.size()))
+        return nullptr;
+
+    return &m_values[location];
+}
+
+GLint RShader::getUniformLocation(const std::string & name)
+{
+    std::map<std::string, GLint>::iterator it = m_locations.find(name);
+
+    if(it == m_locations.end())
+        return -1;
+
+    return it->second;
+}
+
+GLint RShader::getUniformLocation(const RShaderUniform uniform)
+{
+    return m_standardLocations[uniform];
+}
+
+void RShader::setMat4(const GLint location, const glm::mat4 & value)
+{
+    UniformValue *cached = getValue(location);
+    if(cached == nullptr)
+        return;
+
+    const GLfloat *data = glm::value_ptr(value);
+    if(cached->valid && std::memcmp(cached->data, data, 16 * sizeof(GLfloat)) == 0)
+        return;
+
+    std::memcpy(cached->data, data, 16 * sizeof(GLfloat));
+    cached->valid = true;
+
+    glUniformMatrix4fv(location, 1, GL_FALSE, data);
+}
+
+void RShader::setMat4(const RShaderUniform uniform, const glm::mat4 & value)
+{
+    setMat4(m_standardLocations[uniform], value);
+}
+
+void RShader::setVec4(const GLint location, const glm::vec4 & value)
+{
+    UniformValue *cached = getValue(location);
+    if(cached == nullptr)
+        return;
+
+    const GLfloat *data = glm::value_ptr(value);
+    if(cached->valid && std::memcmp(cached->data, data, 4 * sizeof(GLfloat)) == 0)
+        return;
+
+    std::memcpy(cached->data, data, 4 * sizeof(GLfloat));
+    cached->valid = true;
+
+    glUniform4fv(location, 1, data);
+}
+
+void RShader::setVec4(const RShaderUniform uniform, const glm::vec4 & value)
+{
+    setVec4(m_standardLocations[uniform], value);
+}
+
+void RShader::setInt(const GLint location, const GLint value)
+{
+    UniformValue *cached = getValue(location);
+    if(cached == nullptr)
+        return;
+
+    if(cached->valid && cached->integer == value)
+        return;
+
+    cached->integer = value;
+    cached->valid = true;
+
+    glUniform1i(location, value);
+}
+
+void RShader::setInt(const RShaderUniform uniform, const GLint value)
+{
+    setInt(m_standardLocations[uniform], value);
 }
 
 GLuint RShader::getProgram()
@@ -91,6 +261,12 @@ GLuint RShader::getProgram()
 
 void RShader::deleteProgram()
 {
-    glDeleteProgram(m_program);
+    RGLState::deleteProgram(m_program);
+    m_program = 0;
+
+    m_locations.clear();
+    m_values.clear();
+    for(unsigned i = 0; i < UNIFORM_COUNT; ++i)
+        m_standardLocations[i] = -1;
 }
 }
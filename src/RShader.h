@@ -17,10 +17,26 @@
 #ifndef RSHADER_H
 #define RSHADER_H
 
+//C++
+#include <map>
+#include <string>
+#include <vector>
 //GLEW
 #include <GL/glew.h>
+//GLM
+#include <glm/glm.hpp>
 
 namespace Realio {
+//Uniforms shared by the engine's programs
+typedef enum
+{
+    UNIFORM_MODEL,                            //mat4 model
+    UNIFORM_TEXTURE,                          //sampler2D Texture
+    UNIFORM_COLOR,                            //vec4 Color
+    UNIFORM_UV_RECT,                          //vec4 uvRect
+    UNIFORM_COUNT
+} RShaderUniform;
+
 class RShader
 {
 public:
@@ -49,14 +65,80 @@ public:
     GLuint getProgram();
 
     /**
-     * @brief returns the program.
+     * @brief deletes the program.
      * @param void.
-     * @return current shader program, placed in GLuint.
+     * @return void.
      */
     void deleteProgram();
 
+    /**
+     * @brief returns location of the uniform, resolved when the program was linked.
+     * @param name of the uniform.
+     * @return location, -1 if the program has no such uniform.
+     */
+    GLint getUniformLocation(const std::string & name);
+
+    /**
+     * @brief returns location of one of the engine's uniforms without a lookup.
+     * @param RShaderUniform value.
+     * @return location, -1 if the program has no such uniform.
+     */
+    GLint getUniformLocation(const RShaderUniform uniform);
+
+    /**
+     * @brief uploads a matrix, unless the uniform already has this value.
+     * The program must be in use.
+     * @param location or RShaderUniform value and the matrix.
+     * @return void.
+     */
+    void setMat4(const GLint location, const glm::mat4 & value);
+    void setMat4(const RShaderUniform uniform, const glm::mat4 & value);
+
+    /**
+     * @brief uploads a vector, unless the uniform already has this value.
+     * The program must be in use.
+     * @param location or RShaderUniform value and the vector.
+     * @return void.
+     */
+    void setVec4(const GLint location, const glm::vec4 & value);
+    void setVec4(const RShaderUniform uniform, const glm::vec4 & value);
+
+    /**
+     * @brief uploads an integer or a sampler's unit, unless the uniform already
+     * has this value. The program must be in use.
+     * @param location or RShaderUniform value and the integer.
+     * @return void.
+     */
+    void setInt(const GLint location, const GLint value);
+    void setInt(const RShaderUniform uniform, const GLint value);
+
 private:
     GLuint m_program;
+
+    // Last uploaded value of each location
+    struct UniformValue {
+        GLfloat data[16];
+        GLint integer;
+        bool valid;
+    };
+    std::vector<UniformValue> m_values;
+
+    std::map<std::string, GLint> m_locations;
+    GLint m_standardLocations[UNIFORM_COUNT];
+
+    /**
+     * @brief reads active uniforms of the linked program and caches their locations.
+     * @param void.
+     * @return void.
+     */
+    void resolveUniforms();
+
+    /**
+     * @brief returns the cached value of the location.
+     * @param location of the uniform.
+     * @return pointer to the cached value, nullptr for invalid locations.
+     */
+    UniformValue* getValue(const GLint location);
 };
 }
 
@@ -0,0 +1,224 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RShaderCache.h"
+
+namespace Realio {
+/*static*/ RShader* RShaderCache::acquire(const unsigned variant)
+{
+    std::map<unsigned, Entry>::iterator it = entries().find(variant);
+
+    if(it != entries().end())
+    {
+        it->second.refs++;
+        return it->second.shader;
+    }
+
+    Entry entry;
+    entry.shader = compile(variant);
+    entry.refs = 1;
+    entries()[variant] = entry;
+
+    return entry.shader;
+}
+
+/*static*/ void RShaderCache::release(RShader *shader)
+{
+    if(shader == nullptr)
+        return;
+
+    std::map<unsigned, Entry>::iterator it;
+    for(it = entries().begin(); it != entries().end(); ++it)
+    {
+        if(it->second.shader != shader)
+            continue;
+
+        if(--it->second.refs == 0)
+        {
+            shader->deleteProgram();
+            delete shader;
+            entries().erase(it);
+        }
+        return;
+    }
+}
+
+/*static*/ unsigned RShaderCache::getProgramCount()
+{
+    return entries().size();
+}
+
+/*static*/ std::map<unsigned, RShaderCache::Entry>& RShaderCache::entries()
+{
+    static std::map<unsigned, Entry> registry;
+    return registry;
+}
+
+/*static*/ RShader* RShaderCache::compile(const unsigned variant)
+{
+    //Textured quads, drawn as instances
+    if((variant & SHADER_INSTANCED) == SHADER_INSTANCED)
+    {
+        const char vShader[] = {
+            "#version 330 core\n"
+            "layout (location = 0) in vec2 position;"
+            "layout (location = 2) in mat4 transform;"
+            "layout (location = 6) in vec4 uvRect;"
+            "out vec2 TexCoord;"
+            "layout (std140) uniform Camera {"
+            "    mat4 view;"
+            "    mat4 projection;"
+            "    mat4 viewProjection;"
+            "};"
+            "void main() {"
+            "    gl_Position = viewProjection * transform * vec4(position, 0.0f, 1.0f);"
+            "    TexCoord = mix(uvRect.xy, uvRect.zw, vec2(position.x, 1.0 - position.y));"
+            "}"
+        };
+
+        const char fShader[] = {
+            "#version 330 core\n"
+            "in vec2 TexCoord;"
+            "out vec4 color;"
+            "uniform sampler2D Texture;"
+            "void main() {"
+            "    color = texture(Texture, TexCoord).rgba;"
+            "}"
+        };
+
+        return new RShader(vShader, fShader);
+    }
+    //Object colored and textured
+    else if((variant & SHADER_COLORED) && (variant & SHADER_TEXTURED))
+    {
+        const char vShader[] = {
+            "#version 330 core\n"
+            "layout (location = 0) in vec3 position;"
+            "layout (location = 1) in vec2 texCoord;"
+            "out vec2 TexCoord;"
+            "uniform mat4 model;"
+            "layout (std140) uniform Camera {"
+            "    mat4 view;"
+            "    mat4 projection;"
+            "    mat4 viewProjection;"
+            "};"
+            "uniform vec4 uvRect;"
+            "void main() {"
+            "    gl_Position = viewProjection * model * vec4(position, 1.0f);"
+            "    TexCoord = mix(uvRect.xy, uvRect.zw, vec2(texCoord.x, 1.0 - texCoord.y));"
+            "}"
+        };
+
+        const char fShader[] = {
+            "#version 330 core\n"
+            "in vec2 TexCoord;"
+            "out vec4 color;"
+            "uniform sampler2D Texture;"
+            "uniform vec4 Color;"
+            "void main() {"
+            "    color = texture(Texture, TexCoord) * Color;"
+            "}"
+        };
+
+        return new RShader(vShader, fShader);
+    }
+    //Object textured, but not colored
+    else if(variant & SHADER_TEXTURED)
+    {
+        const char vShader[] = {
+            "#version 330 core\n"
+            "layout (location = 0) in vec3 position;"
+            "layout (location = 1) in vec2 texCoord;"
+            "out vec2 TexCoord;"
+            "uniform mat4 model;"
+            "layout (std140) uniform Camera {"
+            "    mat4 view;"
+            "    mat4 projection;"
+            "    mat4 viewProjection;"
+            "};"
+            "uniform vec4 uvRect;"
+            "void main() {"
+            "    gl_Position = viewProjection * model * vec4(position, 1.0f);"
+            "    TexCoord = mix(uvRect.xy, uvRect.zw, vec2(texCoord.x, 1.0 - texCoord.y));"
+            "}"
+        };
+
+        const char fShader[] = {
+            "#version 330 core\n"
+            "in vec2 TexCoord;"
+            "out vec4 color;"
+            "uniform sampler2D Texture;"
+            "void main() {"
+            "    color = texture(Texture, TexCoord).rgba;"
+            "}"
+        };
+
+        return new RShader(vShader, fShader);
+    }
+    //Object colored, but not textured
+    else if(variant & SHADER_COLORED)
+    {
+        const char vShader[] = {
+            "#version 330 core\n"
+            "layout (location = 0) in vec3 position;"
+            "out vec2 TexCoord;"
+            "uniform mat4 model;"
+            "layout (std140) uniform Camera {"
+            "    mat4 view;"
+            "    mat4 projection;"
+            "    mat4 viewProjection;"
+            "};"
+            "void main() {"
+            "    gl_Position = viewProjection * model * vec4(position, 1.0f);"
+            "}"
+        };
+
+        const char fShader[] = {
+            "#version 330 core\n"
+            "out vec4 color;"
+            "uniform vec4 Color;"
+            "void main() {"
+            "    color = Color;"
+            "}"
+        };
+
+        return new RShader(vShader, fShader);
+    }
+
+    const char vShader[] = {
+        "#version 330 core\n"
+        "layout (location = 0) in vec3 position;"
+        "layout (location = 1) in vec2 texCoord;"
+        "out vec2 TexCoord;"
+        "void main() {"
+        "    gl_Position = vec4(position, 1.0f);"
+        "    TexCoord = vec2(texCoord.x, 1.0 - texCoord.y);"
+        "}"
+    };
+    const char fShader[] = {
+        "#version 330 core\n"
+        "in vec2 TexCoord;"
+        "out vec4 color;"
+        "uniform sampler2D tex;"
+        "void main() {"
+        "    color = texture(tex, TexCoord).rgba;"
+        "}"
+    };
+
+    return new RShader(vShader, fShader);
+}
+}
@@ -0,0 +1,83 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RSHADERCACHE_H
+#define RSHADERCACHE_H
+
+//Realio
+#include "RShader.h"
+//C++
+#include <map>
+
+namespace Realio {
+//Shader variants
+typedef enum
+{
+    SHADER_PLAIN        = 0x00000000,         //Neither colored nor textured
+    SHADER_COLORED      = 0x00000001,         //Colored by uniform
+    SHADER_TEXTURED     = 0x00000002,         //Textured
+    SHADER_INSTANCED    = 0x00000004,         //Textured quads with per-instance attributes
+} RShaderVariant;
+
+class RShaderCache
+{
+public:
+    /**
+     * @brief returns the program of the variant, compiling it on first use.
+     * Every call must be paired with release().
+     * @param combination of RShaderVariant flags.
+     * @return pointer to the shared RShader.
+     */
+    static RShader* acquire(const unsigned variant);
+
+    /**
+     * @brief drops a reference to the program and deletes it with the last one.
+     * @param pointer to an RShader returned by acquire().
+     * @return void.
+     */
+    static void release(RShader *shader);
+
+    /**
+     * @brief returns number of programs alive.
+     * @param void.
+     * @return number of linked programs.
+     */
+    static unsigned getProgramCount();
+
+private:
+    struct Entry {
+        RShader *shader;
+        unsigned refs;
+    };
+
+    /**
+     * @brief returns the registry. It's created on first use, so widgets
+     * constructed during static initialization are safe.
+     * @param void.
+     * @return reference to the map of programs by variant.
+     */
+    static std::map<unsigned, Entry>& entries();
+
+    /**
+     * @brief compiles the variant's sources.
+     * @param combination of RShaderVariant flags.
+     * @return pointer to a new RShader.
+     */
+    static RShader* compile(const unsigned variant);
+};
+}
+
+#endif // RSHADERCACHE_H
@@ -0,0 +1,352 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RSpriteBatch.h"
+#include "RGLState.h"
+#include "RMemoryTracker.h"
+#include "RProfiler.h"
+#include "RShaderCache.h"
+//C++
+#include <algorithm>
+#include <cstring>
+
+namespace Realio {
+RSpriteBatch::RSpriteBatch(RQuad *quad, const unsigned maxSprites)
+{
+    m_quad = quad;
+    m_maxSprites = maxSprites;
+    m_vertices.reserve(m_maxSprites * 4);
+
+    m_shader = nullptr;
+    m_texture = 0;
+
+    m_drawCalls = m_sprites = m_culled = 0;
+    m_lastDrawCalls = m_lastSprites = m_lastCulled = 0;
+
+    m_instanced = false;
+
+    // Indices never change, so build them for the whole buffer once
+    std::vector<GLuint> indices(m_maxSprites * 6);
+    for(unsigned i = 0; i < m_maxSprites; ++i)
+    {
+        for(unsigned j = 0; j < 6; ++j)
+            indices[i * 6 + j] = i * 4 + RQuad::indices[j];
+    }
+
+    // A segment fits several full flushes, so a frame rarely waits on a fence
+    m_vertexStream = new RStreamBuffer(GL_ARRAY_BUFFER, m_maxSprites * 4 * sizeof(Vertex) * 4);
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &EBO);
+
+    RGLState::bindVertexArray(VAO);
+
+    // Flushes pick their place in the stream with a base vertex
+    RGLState::bindBuffer(GL_ARRAY_BUFFER, m_vertexStream->getBuffer());
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+    RMemoryTracker::allocate(MEMORY_BUFFERS, EBO, indices.size() * sizeof(GLuint));
+
+    // Position attribute
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)0);
+    glEnableVertexAttribArray(0);
+    // Texture attribute
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)(3 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(1);
+
+    RGLState::bindVertexArray(0); // Unbind VAO
+
+    initializeInstancing();
+}
+
+RSpriteBatch::~RSpriteBatch()
+{
+    RGLState::deleteVertexArray(VAO);
+    RGLState::deleteBuffer(EBO);
+    delete m_vertexStream;
+
+    RGLState::deleteVertexArray(instanceVAO);
+    delete m_instanceStream;
+
+    RShaderCache::release(m_instanceShader);
+    RShaderCache::release(m_texturedShader);
+}
+
+void RSpriteBatch::initializeInstancing()
+{
+    m_instanceShader = RShaderCache::acquire(SHADER_TEXTURED | SHADER_INSTANCED);
+    m_texturedShader = RShaderCache::acquire(SHADER_TEXTURED);
+
+    m_instanceStream = new RStreamBuffer(GL_ARRAY_BUFFER, m_maxSprites * sizeof(Instance) * 4);
+
+    glGenVertexArrays(1, &instanceVAO);
+
+    RGLState::bindVertexArray(instanceVAO);
+
+    // Every instance is the window's unit quad
+    RGLState::bindBuffer(GL_ARRAY_BUFFER, m_quad->getVertexBuffer());
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_quad->getIndexBuffer());
+
+    // Position attribute
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)0);
+    glEnableVertexAttribArray(0);
+
+    for(unsigned i = 2; i < 7; ++i)
+    {
+        glEnableVertexAttribArray(i);
+        glVertexAttribDivisor(i, 1);
+    }
+    pointInstances(0);
+
+    RGLState::bindVertexArray(0); // Unbind VAO
+}
+
+void RSpriteBatch::pointInstances(GLintptr offset)
+{
+    RGLState::bindBuffer(GL_ARRAY_BUFFER, m_instanceStream->getBuffer());
+
+    // Transform attribute takes 4 locations, one per column
+    for(unsigned i = 0; i < 4; ++i)
+        glVertexAttribPointer(2 + i, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (GLvoid*)(offset + i * 4 * sizeof(GLfloat)));
+    // Texture region attribute
+    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (GLvoid*)(offset + 16 * sizeof(GLfloat)));
+}
+
+void RSpriteBatch::begin()
+{
+    m_vertices.clear();
+    m_instances.clear();
+    m_shader = nullptr;
+    m_texture = 0;
+
+    m_drawCalls = m_sprites = m_culled = 0;
+}
+
+void RSpriteBatch::draw(RShader *shader, GLuint texture, const glm::mat4 &transform,
+                        const glm::vec4 &uvRect)
+{
+    if(shader == nullptr)
+        return;
+
+    Vertex quad[4];
+    int left = 0, right = 0, below = 0, above = 0;
+
+    for(unsigned i = 0; i < 4; ++i)
+    {
+        GLfloat x = RQuad::vertices[i * 5];
+        GLfloat y = RQuad::vertices[i * 5 + 1];
+        glm::vec4 pos = transform * glm::vec4(x, y, 0.0f, 1.0f);
+        glm::vec4 clip = m_viewProjection * pos;
+
+        // Shaders flip V, so the region's top is at V = 1
+        quad[i].x = pos.x;
+        quad[i].y = pos.y;
+        quad[i].z = pos.z;
+        quad[i].u = x > 0.5f ? uvRect.z : uvRect.x;
+        quad[i].v = y > 0.5f ? 1.0f - uvRect.y : 1.0f - uvRect.w;
+
+        left += clip.x < -clip.w;
+        right += clip.x > clip.w;
+        below += clip.y < -clip.w;
+        above += clip.y > clip.w;
+    }
+
+    // The whole quad is out of the screen
+    if(left == 4 || right == 4 || below == 4 || above == 4)
+    {
+        m_culled++;
+        return;
+    }
+
+    // The instanced variant only stands in for the plain textured program,
+    // quads of any other program keep their own shader as vertices
+    if(m_instanced && shader == m_texturedShader)
+    {
+        if(!m_vertices.empty() || texture != m_texture)
+        {
+            flush();
+            m_shader = shader;
+            m_texture = texture;
+        }
+
+        Instance instance;
+        instance.transform = transform;
+        instance.uvRect = uvRect;
+        m_instances.push_back(instance);
+    }
+    else
+    {
+        if(!m_instances.empty() || shader != m_shader || texture != m_texture ||
+           m_vertices.size() >= m_maxSprites * 4)
+        {
+            flush();
+            m_shader = shader;
+            m_texture = texture;
+        }
+
+        m_vertices.insert(m_vertices.end(), quad, quad + 4);
+    }
+
+    m_sprites++;
+}
+
+void RSpriteBatch::setInstanced(bool instanced)
+{
+    if(instanced == m_instanced)
+        return;
+
+    flush();
+    m_instanced = instanced;
+    m_shader = nullptr;
+    m_texture = 0;
+}
+
+bool RSpriteBatch::isInstanced()
+{
+    return m_instanced;
+}
+
+void RSpriteBatch::setViewProjection(const glm::mat4 &viewProjection)
+{
+    m_viewProjection = viewProjection;
+}
+
+void RSpriteBatch::flush()
+{
+    REALIO_PROFILE_ZONE("RSpriteBatch::flush");
+
+    // Only one of them holds quads at a time
+    flushInstances();
+    flushVertices();
+}
+
+void RSpriteBatch::flushVertices()
+{
+    if(m_vertices.empty())
+        return;
+
+    // Vertices are already transformed, so the model is an identity
+    glm::mat4 identity;
+
+    m_shader->use();
+
+    RGLState::bindTexture(m_texture);
+    m_shader->setInt(UNIFORM_TEXTURE, 0);
+
+    // Texture coordinates are already mapped to the regions too
+    m_shader->setVec4(UNIFORM_UV_RECT, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+
+    m_shader->setMat4(UNIFORM_MODEL, identity);
+
+    GLsizeiptr size = m_vertices.size() * sizeof(Vertex);
+    GLintptr offset = 0;
+
+    void *memory = m_vertexStream->map(size, sizeof(Vertex), offset);
+    if(memory == nullptr)
+    {
+        m_vertices.clear();
+        return;
+    }
+    std::memcpy(memory, m_vertices.data(), size);
+    RGLState::countBufferUpload(size);
+    m_vertexStream->unmap();
+
+    RGLState::bindVertexArray(VAO);
+    glDrawElementsBaseVertex(GL_TRIANGLES, m_vertices.size() / 4 * 6, GL_UNSIGNED_INT, 0,
+                             offset / sizeof(Vertex));
+    RGLState::countDraw(m_vertices.size() / 2);
+
+    m_drawCalls++;
+    m_vertices.clear();
+}
+
+void RSpriteBatch::flushInstances()
+{
+    if(m_instances.empty())
+        return;
+
+    m_instanceShader->use();
+
+    RGLState::bindTexture(m_texture);
+    m_instanceShader->setInt(UNIFORM_TEXTURE, 0);
+
+    GLsizeiptr size = m_instances.size() * sizeof(Instance);
+    GLintptr offset = 0;
+
+    // Grow the stream instead of splitting the draw
+    if(size > m_instanceStream->getSegmentSize())
+    {
+        GLsizeiptr segmentSize = std::max(size, m_instanceStream->getSegmentSize() * 2);
+        delete m_instanceStream;
+        m_instanceStream = new RStreamBuffer(GL_ARRAY_BUFFER, segmentSize);
+    }
+
+    void *memory = m_instanceStream->map(size, sizeof(Instance), offset);
+    if(memory == nullptr)
+    {
+        m_instances.clear();
+        return;
+    }
+    std::memcpy(memory, m_instances.data(), size);
+    RGLState::countBufferUpload(size);
+    m_instanceStream->unmap();
+
+    RGLState::bindVertexArray(instanceVAO);
+    pointInstances(offset);
+
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, m_instances.size());
+    RGLState::countDraw(m_instances.size() * 2);
+
+    m_drawCalls++;
+    m_instances.clear();
+}
+
+void RSpriteBatch::end()
+{
+    flush();
+
+    m_vertexStream->nextFrame();
+    m_instanceStream->nextFrame();
+
+    m_lastDrawCalls = m_drawCalls;
+    m_lastSprites = m_sprites;
+    m_lastCulled = m_culled;
+}
+
+unsigned RSpriteBatch::getDrawCalls()
+{
+    return m_lastDrawCalls;
+}
+
+unsigned RSpriteBatch::getSpriteCount()
+{
+    return m_lastSprites;
+}
+
+unsigned RSpriteBatch::getCulledCount()
+{
+    return m_lastCulled;
+}
+
+unsigned RSpriteBatch::getSavedDrawCalls()
+{
+    // Without batching every drawn quad costs a draw call, culled ones are
+    // counted by getCulledCount()
+    return m_lastSprites - m_lastDrawCalls;
+}
+}
@@ -0,0 +1,192 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RSPRITEBATCH_H
+#define RSPRITEBATCH_H
+
+//Realio
+#include "RQuad.h"
+#include "RShader.h"
+#include "RStreamBuffer.h"
+//C++
+#include <vector>
+//GLEW
+#include <GL/glew.h>
+//GLM
+#include <glm/glm.hpp>
+
+namespace Realio {
+class RSpriteBatch
+{
+public:
+    explicit RSpriteBatch(RQuad *quad, const unsigned maxSprites = 4096);
+    ~RSpriteBatch();
+
+    /**
+     * @brief starts a new frame and resets the frame's counters.
+     * @param void.
+     * @return void.
+     */
+    void begin();
+
+    /**
+     * @brief queues a textured quad. Quads sharing the shader and the texture
+     * with the previous one are drawn together.
+     * @param shader, texture, transform of the unit quad, region of the texture
+     * (left, top, right, bottom).
+     * @return void.
+     */
+    void draw(RShader *shader, GLuint texture, const glm::mat4 &transform,
+              const glm::vec4 &uvRect);
+
+    /**
+     * @brief switches between streaming transformed vertices and drawing one
+     * shared quad per instance. Only quads of the plain textured program are
+     * drawn as instances, quads of other programs are still streamed.
+     * @param true to draw instances, false to stream vertices.
+     * @return void.
+     */
+    void setInstanced(bool instanced);
+
+    /**
+     * @brief returns true if quads are drawn as instances.
+     * @param void.
+     * @return true, if instancing is on. false, if not.
+     */
+    bool isInstanced();
+
+    /**
+     * @brief sets the camera's matrix used to cull off-screen quads. The matrix
+     * itself comes to the shaders through the camera's uniform block.
+     * @param projection * view matrix.
+     * @return void.
+     */
+    void setViewProjection(const glm::mat4 &viewProjection);
+
+    /**
+     * @brief draws all queued quads. Call it before drawing anything
+     * outside of the batch to keep the order.
+     * @param void.
+     * @return void.
+     */
+    void flush();
+
+    /**
+     * @brief flushes the batch and finishes the frame.
+     * @param void.
+     * @return void.
+     */
+    void end();
+
+    /**
+     * @brief returns number of draw calls issued during the last frame.
+     * @param void.
+     * @return number of draw calls.
+     */
+    unsigned getDrawCalls();
+
+    /**
+     * @brief returns number of quads drawn during the last frame.
+     * @param void.
+     * @return number of quads.
+     */
+    unsigned getSpriteCount();
+
+    /**
+     * @brief returns number of quads skipped as off-screen during the last frame.
+     * @param void.
+     * @return number of quads.
+     */
+    unsigned getCulledCount();
+
+    /**
+     * @brief returns number of draw calls saved by batching during the last
+     * frame. Culled quads aren't included.
+     * @param void.
+     * @return number of draw calls.
+     */
+    unsigned getSavedDrawCalls();
+
+private:
+    struct Vertex {
+        GLfloat x, y, z;
+        GLfloat u, v;
+    };
+    std::vector<Vertex> m_vertices;
+    unsigned m_maxSprites;
+
+    GLuint VAO, EBO;
+    RStreamBuffer *m_vertexStream;
+
+    struct Instance {
+        glm::mat4 transform;
+        glm::vec4 uvRect;
+    };
+    std::vector<Instance> m_instances;
+    bool m_instanced;
+
+    RQuad *m_quad;
+    GLuint instanceVAO;
+    RStreamBuffer *m_instanceStream;
+    RShader *m_instanceShader;
+    RShader *m_texturedShader;
+
+    RShader *m_shader;
+    GLuint m_texture;
+
+    glm::mat4 m_viewProjection;
+
+    // Counters of the current frame
+    unsigned m_drawCalls;
+    unsigned m_sprites;
+    unsigned m_culled;
+
+    // Counters of the last finished frame
+    unsigned m_lastDrawCalls;
+    unsigned m_lastSprites;
+    unsigned m_lastCulled;
+
+    /**
+     * @brief creates the shared quad, the instance buffer and their shaders.
+     * @param void.
+     * @return void.
+     */
+    void initializeInstancing();
+
+    /**
+     * @brief points the instance attributes of the bound VAO into the stream.
+     * @param offset of the first instance in the stream.
+     * @return void.
+     */
+    void pointInstances(GLintptr offset);
+
+    /**
+     * @brief draws queued vertices with one glDrawElements.
+     * @param void.
+     * @return void.
+     */
+    void flushVertices();
+
+    /**
+     * @brief draws queued instances with one glDrawElementsInstanced.
+     * @param void.
+     * @return void.
+     */
+    void flushInstances();
+};
+}
+
+#endif // RSPRITEBATCH_H
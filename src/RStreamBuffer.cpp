@@ -0,0 +1,184 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RStreamBuffer.h"
+#include "RGLState.h"
+#include "RMemoryTracker.h"
+
+namespace Realio {
+namespace {
+const GLbitfield persistentFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+GLintptr alignUp(GLintptr offset, GLsizeiptr alignment)
+{
+    if(alignment <= 1)
+        return offset;
+
+    return (offset + alignment - 1) / alignment * alignment;
+}
+}
+
+RStreamBuffer::RStreamBuffer(GLenum target, GLsizeiptr segmentSize, unsigned segments,
+                             bool allowPersistent)
+{
+    m_target = target;
+    m_segmentSize = segmentSize;
+    m_segments = segments > 0 ? segments : 1;
+    m_persistent = allowPersistent && (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage);
+
+    m_memory = nullptr;
+    m_fences.assign(m_segments, (GLsync)0);
+    m_segment = 0;
+    m_cursor = 0;
+    m_mapped = false;
+
+    GLsizeiptr total = m_segmentSize * m_segments;
+
+    glGenBuffers(1, &m_buffer);
+    RGLState::bindBuffer(m_target, m_buffer);
+
+    if(m_persistent)
+    {
+        glBufferStorage(m_target, total, NULL, persistentFlags);
+        m_memory = (char*)glMapBufferRange(m_target, 0, total, persistentFlags);
+
+        // Some drivers expose the extension, but refuse to map
+        if(m_memory == nullptr)
+        {
+            RGLState::deleteBuffer(m_buffer);
+            glGenBuffers(1, &m_buffer);
+            RGLState::bindBuffer(m_target, m_buffer);
+            m_persistent = false;
+        }
+    }
+
+    if(!m_persistent)
+        glBufferData(m_target, total, NULL, GL_STREAM_DRAW);
+
+    RMemoryTracker::allocate(MEMORY_BUFFERS, m_buffer, total);
+}
+
+RStreamBuffer::~RStreamBuffer()
+{
+    if(m_persistent || m_mapped)
+    {
+        RGLState::bindBuffer(m_target, m_buffer);
+        glUnmapBuffer(m_target);
+    }
+
+    for(unsigned i = 0; i < m_fences.size(); ++i)
+        if(m_fences[i])
+            glDeleteSync(m_fences[i]);
+
+    RGLState::deleteBuffer(m_buffer);
+}
+
+void* RStreamBuffer::map(GLsizeiptr size, GLsizeiptr alignment, GLintptr &offset)
+{
+    if(size > m_segmentSize)
+        return nullptr;
+
+    if(m_persistent)
+    {
+        GLintptr base = m_segment * m_segmentSize;
+        offset = alignUp(base + m_cursor, alignment);
+
+        if(offset + size > base + m_segmentSize)
+        {
+            retireSegment();
+            base = m_segment * m_segmentSize;
+            offset = alignUp(base, alignment);
+        }
+
+        m_cursor = offset + size - base;
+        return m_memory + offset;
+    }
+
+    GLsizeiptr total = m_segmentSize * m_segments;
+    offset = alignUp(m_cursor, alignment);
+
+    RGLState::bindBuffer(m_target, m_buffer);
+
+    // Give the old storage to the driver and start over
+    if(offset + size > total)
+    {
+        glBufferData(m_target, total, NULL, GL_STREAM_DRAW);
+        offset = 0;
+    }
+
+    // Nothing before the cursor is overwritten until orphaning, so don't sync
+    void *memory = glMapBufferRange(m_target, offset, size,
+                                    GL_MAP_WRITE_BIT |
+                                    GL_MAP_INVALIDATE_RANGE_BIT |
+                                    GL_MAP_UNSYNCHRONIZED_BIT);
+    m_cursor = offset + size;
+    m_mapped = memory != nullptr;
+
+    return memory;
+}
+
+void RStreamBuffer::unmap()
+{
+    if(!m_mapped)
+        return;
+
+    RGLState::bindBuffer(m_target, m_buffer);
+    glUnmapBuffer(m_target);
+    m_mapped = false;
+}
+
+void RStreamBuffer::nextFrame()
+{
+    if(m_persistent && m_cursor > 0)
+        retireSegment();
+}
+
+GLuint RStreamBuffer::getBuffer()
+{
+    return m_buffer;
+}
+
+GLsizeiptr RStreamBuffer::getSegmentSize()
+{
+    return m_segmentSize;
+}
+
+bool RStreamBuffer::isPersistent()
+{
+    return m_persistent;
+}
+
+void RStreamBuffer::retireSegment()
+{
+    m_fences[m_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    m_segment = (m_segment + 1) % m_segments;
+    m_cursor = 0;
+
+    GLsync fence = m_fences[m_segment];
+    if(!fence)
+        return;
+
+    // Only blocks, if the GPU is still reading the segment written segments ago
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while(glClientWaitSync(fence, flags, 1000000) == GL_TIMEOUT_EXPIRED)
+        flags = 0;
+
+    glDeleteSync(fence);
+    m_fences[m_segment] = 0;
+}
+}
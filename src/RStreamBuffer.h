@@ -0,0 +1,108 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RSTREAMBUFFER_H
+#define RSTREAMBUFFER_H
+
+//C++
+#include <vector>
+//GLEW
+#include <GL/glew.h>
+
+namespace Realio {
+class RStreamBuffer
+{
+public:
+    /**
+     * @brief creates a ring of segments. With GL 4.4 or ARB_buffer_storage the
+     * buffer is mapped once and every segment is guarded by a fence. Otherwise
+     * ranges are mapped unsynchronized and the buffer is orphaned when full.
+     * @param target (not GL_ELEMENT_ARRAY_BUFFER), size of a segment, number
+     * of segments and whether persistent mapping may be used.
+     */
+    RStreamBuffer(GLenum target, GLsizeiptr segmentSize, unsigned segments = 3,
+                  bool allowPersistent = true);
+    ~RStreamBuffer();
+
+    /**
+     * @brief reserves space for writing. The pointer is valid until unmap().
+     * @param size and alignment of the data, place for offset in the buffer.
+     * @return pointer to write to, nullptr if the data is bigger than a segment.
+     */
+    void* map(GLsizeiptr size, GLsizeiptr alignment, GLintptr &offset);
+
+    /**
+     * @brief finishes writing the reserved space.
+     * @param void.
+     * @return void.
+     */
+    void unmap();
+
+    /**
+     * @brief fences the data written since the last call and moves to the next segment.
+     * Call it once per frame.
+     * @param void.
+     * @return void.
+     */
+    void nextFrame();
+
+    /**
+     * @brief returns the buffer.
+     * @param void.
+     * @return buffer, placed in GLuint.
+     */
+    GLuint getBuffer();
+
+    /**
+     * @brief returns size of a segment.
+     * @param void.
+     * @return size in bytes.
+     */
+    GLsizeiptr getSegmentSize();
+
+    /**
+     * @brief returns true, if the buffer is persistently mapped.
+     * @param void.
+     * @return true for persistent mapping, false for orphaning.
+     */
+    bool isPersistent();
+
+private:
+    GLenum m_target;
+    GLuint m_buffer;
+    GLsizeiptr m_segmentSize;
+    unsigned m_segments;
+    bool m_persistent;
+
+    // Persistent mapping of the whole buffer
+    char *m_memory;
+    std::vector<GLsync> m_fences;
+    unsigned m_segment;
+
+    // Write position in the current segment, or in the whole buffer for orphaning
+    GLintptr m_cursor;
+    bool m_mapped;
+
+    /**
+     * @brief fences the current segment and waits for the next one to be free.
+     * @param void.
+     * @return void.
+     */
+    void retireSegment();
+};
+}
+
+#endif // RSTREAMBUFFER_H
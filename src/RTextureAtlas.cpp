@@ -0,0 +1,282 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RTextureAtlas.h"
+#include "RGLState.h"
+#include "RMemoryTracker.h"
+#include "RProfiler.h"
+//C++
+#include <algorithm>
+#include <climits>
+#include <iostream>
+#include <map>
+#include <utility>
+
+namespace Realio {
+namespace {
+bool tallerFirst(RPixmap *a, RPixmap *b)
+{
+    return a->getImageHeight() > b->getImageHeight();
+}
+}
+
+RTextureAtlas::RTextureAtlas(const int pageWidth, const int pageHeight, const int padding)
+{
+    m_pageWidth = pageWidth;
+    m_pageHeight = pageHeight;
+    m_padding = padding;
+}
+
+RTextureAtlas::~RTextureAtlas()
+{
+    for(unsigned i = 0; i < m_pages.size(); ++i)
+    {
+        RGLState::deleteTexture(m_pages[i]->texture);
+        delete m_pages[i];
+    }
+}
+
+bool RTextureAtlas::addPixmap(RPixmap *pixmap)
+{
+    if(pixmap->getImage() == nullptr)
+    {
+        std::cerr << "Could not add pixmap to RTextureAtlas: image is not loaded" << std::endl;
+        return false;
+    }
+
+    if(pixmap->getImageWidth() + 2 * m_padding > m_pageWidth ||
+       pixmap->getImageHeight() + 2 * m_padding > m_pageHeight)
+    {
+        std::cerr << "Could not add pixmap to RTextureAtlas: image is bigger than a page" << std::endl;
+        return false;
+    }
+
+    m_pending.push_back(pixmap);
+    return true;
+}
+
+void RTextureAtlas::build()
+{
+    REALIO_PROFILE_ZONE("RTextureAtlas::build");
+
+    // Skyline packs much tighter, when rectangles come sorted by height
+    std::stable_sort(m_pending.begin(), m_pending.end(), tallerFirst);
+
+    // Pixmaps of one cached file share their image, so pack it once
+    std::map<const unsigned char*, std::pair<GLuint, glm::vec4> > packed;
+
+    for(unsigned i = 0; i < m_pending.size(); ++i)
+    {
+        RPixmap *pixmap = m_pending[i];
+
+        // The pixmap was shown after adding, its image is gone
+        if(pixmap->getImage() == nullptr)
+        {
+            std::cerr << "Could not pack pixmap into RTextureAtlas: image is already uploaded" << std::endl;
+            continue;
+        }
+
+        std::map<const unsigned char*, std::pair<GLuint, glm::vec4> >::iterator it;
+        it = packed.find(pixmap->getImage());
+        if(it != packed.end())
+        {
+            pixmap->setAtlasRegion(it->second.first, it->second.second);
+            continue;
+        }
+
+        int w = pixmap->getImageWidth() + 2 * m_padding;
+        int h = pixmap->getImageHeight() + 2 * m_padding;
+        int x = 0, y = 0;
+
+        Page *page = nullptr;
+        int node = -1;
+
+        for(unsigned p = 0; p < m_pages.size() && node < 0; ++p)
+        {
+            node = findPosition(m_pages[p], w, h, x, y);
+            if(node >= 0)
+                page = m_pages[p];
+        }
+
+        if(node < 0)
+        {
+            page = createPage();
+            node = findPosition(page, w, h, x, y);
+        }
+
+        addSkylineLevel(page, node, x, y, w, h);
+        uploadRegion(page, pixmap, x, y);
+
+        glm::vec4 uvRect(float(x + m_padding) / float(m_pageWidth),
+                         float(y + m_padding) / float(m_pageHeight),
+                         float(x + w - m_padding) / float(m_pageWidth),
+                         float(y + h - m_padding) / float(m_pageHeight));
+        packed[pixmap->getImage()] = std::make_pair(page->texture, uvRect);
+        pixmap->setAtlasRegion(page->texture, uvRect);
+    }
+
+    m_pending.clear();
+}
+
+unsigned RTextureAtlas::getPageCount()
+{
+    return m_pages.size();
+}
+
+GLuint RTextureAtlas::getPage(unsigned index)
+{
+    if(index >= m_pages.size())
+        return 0;
+
+    return m_pages[index]->texture;
+}
+
+int RTextureAtlas::findPosition(Page *page, int w, int h, int &x, int &y)
+{
+    int bestIndex = -1;
+    int bestY = INT_MAX;
+    int bestWidth = INT_MAX;
+
+    for(unsigned i = 0; i < page->skyline.size(); ++i)
+    {
+        int nodeX = page->skyline[i].x;
+        if(nodeX + w > m_pageWidth)
+            break;
+
+        // The rectangle rests on the highest node it spans
+        int top = 0;
+        int remaining = w;
+        for(unsigned j = i; remaining > 0; ++j)
+        {
+            top = std::max(top, page->skyline[j].y);
+            remaining -= page->skyline[j].width;
+        }
+
+        if(top + h > m_pageHeight)
+            continue;
+
+        if(top < bestY || (top == bestY && page->skyline[i].width < bestWidth))
+        {
+            bestIndex = i;
+            bestY = top;
+            bestWidth = page->skyline[i].width;
+            x = nodeX;
+            y = top;
+        }
+    }
+
+    return bestIndex;
+}
+
+void RTextureAtlas::addSkylineLevel(Page *page, int index, int x, int y, int w, int h)
+{
+    SkylineNode level;
+    level.x = x;
+    level.y = y + h;
+    level.width = w;
+
+    std::vector<SkylineNode> &skyline = page->skyline;
+    skyline.insert(skyline.begin() + index, level);
+
+    // Cut the nodes, which are covered by the new level
+    for(unsigned i = index + 1; i < skyline.size(); ++i)
+    {
+        int shrink = skyline[i - 1].x + skyline[i - 1].width - skyline[i].x;
+        if(shrink <= 0)
+            break;
+
+        skyline[i].x += shrink;
+        skyline[i].width -= shrink;
+
+        if(skyline[i].width > 0)
+            break;
+
+        skyline.erase(skyline.begin() + i);
+        --i;
+    }
+
+    // Merge neighbours of the same height
+    for(unsigned i = 0; i + 1 < skyline.size(); ++i)
+    {
+        if(skyline[i].y == skyline[i + 1].y)
+        {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+            --i;
+        }
+    }
+}
+
+RTextureAtlas::Page* RTextureAtlas::createPage()
+{
+    Page *page = new Page;
+
+    SkylineNode ground;
+    ground.x = 0;
+    ground.y = 0;
+    ground.width = m_pageWidth;
+    page->skyline.push_back(ground);
+
+    glGenTextures(1, &page->texture);
+    RGLState::bindTexture(page->texture);
+
+    // Regions are tightly packed, so never wrap into a neighbour
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_pageWidth, m_pageHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    RMemoryTracker::allocate(MEMORY_TEXTURES, page->texture,
+                             RMemoryTracker::textureSize(m_pageWidth, m_pageHeight, 4, false));
+
+    m_pages.push_back(page);
+    return page;
+}
+
+void RTextureAtlas::uploadRegion(Page *page, RPixmap *pixmap, int x, int y)
+{
+    const unsigned char *image = pixmap->getImage();
+    int imgWidth = pixmap->getImageWidth();
+    int imgHeight = pixmap->getImageHeight();
+    int w = imgWidth + 2 * m_padding;
+    int h = imgHeight + 2 * m_padding;
+
+    std::vector<unsigned char> pixels(w * h * 4);
+
+    for(int row = 0; row < h; ++row)
+    {
+        int srcRow = std::min(std::max(row - m_padding, 0), imgHeight - 1);
+        for(int col = 0; col < w; ++col)
+        {
+            int srcCol = std::min(std::max(col - m_padding, 0), imgWidth - 1);
+            const unsigned char *src = image + (srcRow * imgWidth + srcCol) * 4;
+            unsigned char *dst = &pixels[(row * w + col) * 4];
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+            dst[3] = src[3];
+        }
+    }
+
+    RGLState::bindTexture(page->texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    RGLState::countTextureUpload(pixels.size());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+}
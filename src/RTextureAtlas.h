@@ -0,0 +1,112 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RTEXTUREATLAS_H
+#define RTEXTUREATLAS_H
+
+//Realio
+#include "RPixmap.h"
+//C++
+#include <vector>
+//GLEW
+#include <GL/glew.h>
+
+namespace Realio {
+class RTextureAtlas
+{
+public:
+    RTextureAtlas(const int pageWidth = 2048, const int pageHeight = 2048, const int padding = 1);
+    ~RTextureAtlas();
+
+    /**
+     * @brief adds the pixmap's image to the atlas. Call it after loadFile()
+     * and before build().
+     * @param pointer to an RPixmap with loaded image.
+     * @return True, if the image fits into a page. False, if not.
+     */
+    bool addPixmap(RPixmap *pixmap);
+
+    /**
+     * @brief packs all added images into pages, uploads the pages and
+     * points every added pixmap to its region.
+     * @param void.
+     * @return void.
+     */
+    void build();
+
+    /**
+     * @brief returns number of the atlas' pages.
+     * @param void.
+     * @return number of pages.
+     */
+    unsigned getPageCount();
+
+    /**
+     * @brief returns the page's texture.
+     * @param index of the page.
+     * @return texture of the page, 0 if there is no such page.
+     */
+    GLuint getPage(unsigned index);
+
+private:
+    struct SkylineNode {
+        int x, y, width;
+    };
+
+    struct Page {
+        std::vector<SkylineNode> skyline;
+        GLuint texture;
+    };
+
+    std::vector<Page*> m_pages;
+    std::vector<RPixmap*> m_pending;
+
+    int m_pageWidth;
+    int m_pageHeight;
+    int m_padding;
+
+    /**
+     * @brief finds the lowest place for a rectangle in the page's skyline.
+     * @param page, rectangle's size and place for the result.
+     * @return index of the skyline node to start at, -1 if there is no place.
+     */
+    int findPosition(Page *page, int w, int h, int &x, int &y);
+
+    /**
+     * @brief raises the page's skyline over a placed rectangle.
+     * @param page, index of the starting node and the rectangle.
+     * @return void.
+     */
+    void addSkylineLevel(Page *page, int index, int x, int y, int w, int h);
+
+    /**
+     * @brief creates an empty page.
+     * @param void.
+     * @return pointer to the new page.
+     */
+    Page* createPage();
+
+    /**
+     * @brief uploads the pixmap's image to the page with its edges
+     * extruded into the padding, so filtering doesn't bleed neighbours in.
+     * @param page, pixmap and position of the padded rectangle.
+     * @return void.
+     */
+    void uploadRegion(Page *page, RPixmap *pixmap, int x, int y);
+};
+}
+
+#endif // RTEXTUREATLAS_H
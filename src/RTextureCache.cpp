@@ -0,0 +1,386 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RTextureCache.h"
+#include "RAssetPack.h"
+#include "RGLState.h"
+#include "RMemoryTracker.h"
+#include "RMipmapBuilder.h"
+#include "RPixmap.h"
+#include "RProfiler.h"
+#include "RTextureFile.h"
+#include "RTextureUploader.h"
+//C++
+#include <algorithm>
+#include <iostream>
+#include <utility>
+//STB
+#include "stb/stb_image.h"
+
+namespace Realio {
+size_t RTextureCache::m_budget = 0;
+unsigned long RTextureCache::m_frame = 0;
+unsigned RTextureCache::m_evictions = 0;
+
+/*static*/ RCachedTexture* RTextureCache::acquire(const char *path, RPixmap *pixmap)
+{
+    RCachedTexture *entry = find(path, pixmap);
+    if(entry != nullptr)
+        return entry;
+
+    entry = create(path, pixmap);
+    if(!decode(entry))
+    {
+        delete entry;
+        return nullptr;
+    }
+
+    entries()[entry->path] = entry;
+
+    return entry;
+}
+
+/*static*/ RCachedTexture* RTextureCache::insert(const char *path, unsigned char *image, RMipChain *mips,
+                                                 int width, int height, RPixmap *pixmap)
+{
+    // A synchronous load of the file was quicker
+    RCachedTexture *entry = find(path, pixmap);
+    if(entry != nullptr)
+    {
+        RMemoryTracker::release(MEMORY_DECODED_IMAGES, (uintptr_t)image);
+        stbi_image_free(image);
+        RMipmapBuilder::destroy(mips);
+        return entry;
+    }
+
+    entry = create(path, pixmap);
+    entry->image = image;
+    entry->mips = mips;
+    entry->width = width;
+    entry->height = height;
+    charge(entry);
+
+    entries()[entry->path] = entry;
+
+    return entry;
+}
+
+/*static*/ RCachedTexture* RTextureCache::find(const char *path, RPixmap *pixmap)
+{
+    std::map<std::string, RCachedTexture*>::iterator it = entries().find(path);
+    if(it == entries().end())
+        return nullptr;
+
+    it->second->refs++;
+    it->second->users.push_back(pixmap);
+    return it->second;
+}
+
+/*static*/ void RTextureCache::upload(RCachedTexture *entry, RPixmap *pixmap)
+{
+    if(entry == nullptr || entry->texture)
+        return;
+
+    // The texture was evicted, its file is the only copy left
+    if(!entry->image && !entry->upload && !decode(entry))
+        return;
+
+    if(entry->upload || RTextureUploader::isEnabled())
+    {
+        if(!entry->upload)
+        {
+            entry->upload = RTextureUploader::enqueue(entry);
+            // The uploader frees the image
+            entry->image = nullptr;
+            entry->file = nullptr;
+            entry->mips = nullptr;
+        }
+
+        if(std::find(entry->waiting.begin(), entry->waiting.end(), pixmap) == entry->waiting.end())
+            entry->waiting.push_back(pixmap);
+        return;
+    }
+
+    REALIO_PROFILE_ZONE("RTextureCache::upload");
+
+    glGenTextures(1, &entry->texture);
+    RGLState::bindTexture(entry->texture);
+
+    // Set texture parameters
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    // Set texture filtering, the mip chain is sampled however it's built
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    if(entry->file != nullptr)
+    {
+        // Mipmaps are in the file, so every level is a plain copy
+        for(unsigned i = 0; i < entry->file->getLevels(); ++i)
+        {
+            int width, height;
+            const unsigned char *level = entry->file->getLevel(i, width, height);
+
+            glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, level);
+            RGLState::countTextureUpload(width * height * 4);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, entry->file->getLevels() - 1);
+    }
+    else
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, entry->width, entry->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, entry->image);
+        RGLState::countTextureUpload(entry->width * entry->height * 4);
+
+        if(entry->mips != nullptr)
+            RMipmapBuilder::upload(entry->mips);
+        else
+            glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+    RMemoryTracker::allocate(MEMORY_TEXTURES, entry->texture,
+                             RMemoryTracker::textureSize(entry->width, entry->height, 4, true), getOwner(entry));
+
+    // The texture keeps the pixels now
+    freeImage(entry);
+}
+
+/*static*/ void RTextureCache::uploaded(RCachedTexture *entry, GLuint texture)
+{
+    entry->texture = texture;
+    entry->upload = 0;
+    charge(entry);
+
+    std::vector<RPixmap*> waiting;
+    waiting.swap(entry->waiting);
+
+    for(unsigned i = 0; i < waiting.size(); ++i)
+        waiting[i]->textureUploaded(0, texture);
+}
+
+/*static*/ void RTextureCache::release(RCachedTexture *entry, RPixmap *pixmap)
+{
+    if(entry == nullptr)
+        return;
+
+    entry->waiting.erase(std::remove(entry->waiting.begin(), entry->waiting.end(), pixmap),
+                         entry->waiting.end());
+
+    std::vector<RPixmap*>::iterator user = std::find(entry->users.begin(), entry->users.end(), pixmap);
+    bool charged = user == entry->users.begin();
+    if(user != entry->users.end())
+        entry->users.erase(user);
+
+    if(--entry->refs > 0)
+    {
+        // The next user pays for the entry
+        if(charged)
+            charge(entry);
+        return;
+    }
+
+    if(entry->upload)
+        RTextureUploader::cancel(entry->upload);
+
+    freeImage(entry);
+
+    if(entry->texture)
+        RGLState::deleteTexture(entry->texture);
+
+    entries().erase(entry->path);
+    delete entry;
+}
+
+/*static*/ void RTextureCache::setBudget(size_t bytes)
+{
+    m_budget = bytes;
+}
+
+/*static*/ size_t RTextureCache::getBudget()
+{
+    return m_budget;
+}
+
+/*static*/ void RTextureCache::touch(RCachedTexture *entry)
+{
+    entry->lastUsed = m_frame;
+}
+
+/*static*/ unsigned RTextureCache::trim()
+{
+    unsigned evicted = 0;
+    size_t resident = getResidentBytes();
+
+    if(m_budget > 0 && resident > m_budget)
+    {
+        std::vector<std::pair<unsigned long, RCachedTexture*> > cold;
+
+        std::map<std::string, RCachedTexture*>::iterator it;
+        for(it = entries().begin(); it != entries().end(); ++it)
+            if(it->second->texture && it->second->lastUsed < m_frame)
+                cold.push_back(std::make_pair(it->second->lastUsed, it->second));
+
+        std::sort(cold.begin(), cold.end());
+
+        for(unsigned i = 0; i < cold.size() && resident > m_budget; ++i)
+        {
+            RCachedTexture *entry = cold[i].second;
+            resident -= RMemoryTracker::textureSize(entry->width, entry->height, 4, true);
+            evict(entry);
+            evicted++;
+        }
+    }
+
+    m_frame++;
+    return evicted;
+}
+
+/*static*/ size_t RTextureCache::getResidentBytes()
+{
+    size_t bytes = 0;
+
+    std::map<std::string, RCachedTexture*>::iterator it;
+    for(it = entries().begin(); it != entries().end(); ++it)
+        if(it->second->texture)
+            bytes += RMemoryTracker::textureSize(it->second->width, it->second->height, 4, true);
+
+    return bytes;
+}
+
+/*static*/ unsigned RTextureCache::getEvictionCount()
+{
+    return m_evictions;
+}
+
+/*static*/ unsigned RTextureCache::getEntryCount()
+{
+    return entries().size();
+}
+
+/*static*/ RCachedTexture* RTextureCache::create(const char *path, RPixmap *pixmap)
+{
+    RCachedTexture *entry = new RCachedTexture;
+    entry->path = path;
+    entry->image = nullptr;
+    entry->file = nullptr;
+    entry->mips = nullptr;
+    entry->width = entry->height = 0;
+    entry->texture = 0;
+    entry->refs = 1;
+    entry->upload = 0;
+    entry->users.push_back(pixmap);
+    entry->lastUsed = m_frame;
+    return entry;
+}
+
+/*static*/ bool RTextureCache::decode(RCachedTexture *entry)
+{
+    if(RTextureFile::isTextureFile(entry->path.c_str()))
+    {
+        RTextureFile *file = new RTextureFile;
+        if(!file->open(entry->path.c_str()))
+        {
+            delete file;
+            return false;
+        }
+
+        entry->file = file;
+        entry->image = file->getLevel(0, entry->width, entry->height);
+
+        // Mapped pages count as decoded ones, though the system may drop them
+        RMemoryTracker::allocate(MEMORY_DECODED_IMAGES, (uintptr_t)file, file->getSize(), getOwner(entry));
+        return true;
+    }
+
+    int components;
+    std::string error;
+    {
+        REALIO_PROFILE_ZONE("stbi_load");
+        entry->image = RAssetPack::loadImage(entry->path.c_str(), entry->width, entry->height, components, error);
+    }
+
+    if(!entry->image)
+    {
+        std::cerr << "Could not load image '" << entry->path << "' to RTextureCache: ";
+        std::cerr << error << std::endl;
+        return false;
+    }
+
+    // A synchronous load splits the mipmaps between all cores
+    if(RMipmapBuilder::isEnabled())
+        entry->mips = RMipmapBuilder::build(entry->image, entry->width, entry->height, getOwner(entry));
+
+    RMemoryTracker::allocate(MEMORY_DECODED_IMAGES, (uintptr_t)entry->image,
+                             entry->width * entry->height * 4, getOwner(entry));
+    return true;
+}
+
+/*static*/ unsigned RTextureCache::getOwner(RCachedTexture *entry)
+{
+    // Shared memory counts for the first user, not for every one
+    return entry->users.empty() ? 0 : entry->users.front()->getID();
+}
+
+/*static*/ void RTextureCache::charge(RCachedTexture *entry)
+{
+    unsigned owner = getOwner(entry);
+
+    if(entry->file != nullptr)
+        RMemoryTracker::setOwner(MEMORY_DECODED_IMAGES, (uintptr_t)entry->file, owner);
+    else if(entry->image)
+        RMemoryTracker::setOwner(MEMORY_DECODED_IMAGES, (uintptr_t)entry->image, owner);
+    if(entry->mips != nullptr)
+        RMemoryTracker::setOwner(MEMORY_DECODED_IMAGES, (uintptr_t)entry->mips, owner);
+    if(entry->texture)
+        RMemoryTracker::setOwner(MEMORY_TEXTURES, entry->texture, owner);
+}
+
+/*static*/ void RTextureCache::freeImage(RCachedTexture *entry)
+{
+    if(entry->file != nullptr)
+    {
+        RMemoryTracker::release(MEMORY_DECODED_IMAGES, (uintptr_t)entry->file);
+        delete entry->file;
+    }
+    else if(entry->image)
+    {
+        RMemoryTracker::release(MEMORY_DECODED_IMAGES, (uintptr_t)entry->image);
+        stbi_image_free((void*)entry->image);
+    }
+    RMipmapBuilder::destroy(entry->mips);
+
+    entry->image = nullptr;
+    entry->file = nullptr;
+    entry->mips = nullptr;
+}
+
+/*static*/ void RTextureCache::evict(RCachedTexture *entry)
+{
+    for(unsigned i = 0; i < entry->users.size(); ++i)
+        if(entry->users[i]->m_texture == entry->texture)
+            entry->users[i]->m_texture = 0;
+
+    RGLState::deleteTexture(entry->texture);
+    entry->texture = 0;
+    m_evictions++;
+}
+
+/*static*/ std::map<std::string, RCachedTexture*>& RTextureCache::entries()
+{
+    static std::map<std::string, RCachedTexture*> registry;
+    return registry;
+}
+}
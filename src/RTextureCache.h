@@ -0,0 +1,219 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RTEXTURECACHE_H
+#define RTEXTURECACHE_H
+
+//C++
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+//GLEW
+#include <GL/glew.h>
+
+namespace Realio {
+class RPixmap;
+class RTextureFile;
+struct RMipChain;
+
+struct RCachedTexture
+{
+    std::string path;
+    // Decoded RGBA pixels, freed once the texture is uploaded and
+    // decoded again, when an evicted texture is needed
+    const unsigned char *image;
+    // Mapped texture file with its mipmaps, the image is its base level then
+    RTextureFile *file;
+    // Mipmaps built with the image by RMipmapBuilder, if it's enabled
+    RMipChain *mips;
+    int width, height;
+    // 0 until the first upload and after eviction
+    GLuint texture;
+    unsigned refs;
+    // Ticket of the streamed upload and pixmaps waiting for it
+    unsigned upload;
+    std::vector<RPixmap*> waiting;
+    // Pixmaps holding the references
+    std::vector<RPixmap*> users;
+    // Last frame the texture was on the screen
+    unsigned long lastUsed;
+};
+
+class RTextureCache
+{
+public:
+    /**
+     * @brief returns the image of the file, decoding it on first use.
+     * Texture files (see RTextureFile) are mapped instead of decoded.
+     * Every successful call must be paired with release().
+     * @param path to the file and pixmap taking the reference.
+     * @return pointer to the shared entry, nullptr if the file can't be decoded.
+     */
+    static RCachedTexture* acquire(const char *path, RPixmap *pixmap);
+
+    /**
+     * @brief caches an image decoded elsewhere, e.g. by RImageLoader. If the file
+     * got cached meanwhile, the image is freed and the cached one is shared.
+     * The call must be paired with release() like acquire().
+     * @param path to the file, its image, mipmaps (may be nullptr), size and pixmap taking the reference.
+     * @return pointer to the shared entry.
+     */
+    static RCachedTexture* insert(const char *path, unsigned char *image, RMipChain *mips,
+                                  int width, int height, RPixmap *pixmap);
+
+    /**
+     * @brief returns the file's entry, if it's already cached, without decoding.
+     * A found entry must be released like an acquired one.
+     * @param path to the file and pixmap taking the reference.
+     * @return pointer to the shared entry, nullptr if it isn't cached.
+     */
+    static RCachedTexture* find(const char *path, RPixmap *pixmap);
+
+    /**
+     * @brief uploads the entry's image to its texture, unless it's uploaded
+     * already, and frees the image. An evicted texture is decoded from the
+     * file again. With RTextureUploader enabled the texture is streamed
+     * instead and the pixmap gets it, when it's complete.
+     * @param pointer to an acquired entry and pixmap waiting for the texture.
+     * @return void.
+     */
+    static void upload(RCachedTexture *entry, RPixmap *pixmap);
+
+    /**
+     * @brief gives the streamed texture to the entry and its waiting pixmaps.
+     * RTextureUploader calls it.
+     * @param entry and its complete texture.
+     * @return void.
+     */
+    static void uploaded(RCachedTexture *entry, GLuint texture);
+
+    /**
+     * @brief drops a reference to the entry and deletes its image and texture with the last one.
+     * @param pointer to an acquired entry and pixmap, which took the reference.
+     * @return void.
+     */
+    static void release(RCachedTexture *entry, RPixmap *pixmap);
+
+    /**
+     * @brief sets how many bytes of cached textures may stay on the GPU.
+     * Over the budget trim() evicts the textures unused for the longest time.
+     * @param number of bytes, 0 for no limit.
+     * @return void.
+     */
+    static void setBudget(size_t bytes);
+
+    /**
+     * @brief returns the budget.
+     * @param void.
+     * @return number of bytes, 0 if there is no limit.
+     */
+    static size_t getBudget();
+
+    /**
+     * @brief marks the entry's texture as used in this frame.
+     * @param pointer to an acquired entry.
+     * @return void.
+     */
+    static void touch(RCachedTexture *entry);
+
+    /**
+     * @brief evicts textures, which aren't used in this frame, coldest first,
+     * until the rest fits into the budget, then starts a new frame. Pixmaps
+     * of evicted textures reload them, when they are on the screen again.
+     * @param void.
+     * @return number of evicted textures.
+     */
+    static unsigned trim();
+
+    /**
+     * @brief returns bytes of the cached textures on the GPU.
+     * @param void.
+     * @return number of bytes.
+     */
+    static size_t getResidentBytes();
+
+    /**
+     * @brief returns number of textures evicted since the start.
+     * @param void.
+     * @return number of evictions.
+     */
+    static unsigned getEvictionCount();
+
+    /**
+     * @brief returns number of cached files.
+     * @param void.
+     * @return number of entries.
+     */
+    static unsigned getEntryCount();
+
+private:
+    static size_t m_budget;
+    static unsigned long m_frame;
+    static unsigned m_evictions;
+
+    /**
+     * @brief makes an empty entry with the pixmap's reference, which isn't registered yet.
+     * @param path to the file and pixmap taking the reference.
+     * @return pointer to the new entry.
+     */
+    static RCachedTexture* create(const char *path, RPixmap *pixmap);
+
+    /**
+     * @brief decodes the entry's file into its image or maps it, if it's a texture file.
+     * @param entry.
+     * @return true, if the file is decoded. false, if not.
+     */
+    static bool decode(RCachedTexture *entry);
+
+    /**
+     * @brief returns the widget the entry's memory counts for.
+     * @param entry.
+     * @return ID of the first user, 0 if there is none.
+     */
+    static unsigned getOwner(RCachedTexture *entry);
+
+    /**
+     * @brief moves the entry's recorded image and texture to its current owner.
+     * @param entry.
+     * @return void.
+     */
+    static void charge(RCachedTexture *entry);
+
+    /**
+     * @brief frees the entry's image and its mipmaps or unmaps its file.
+     * @param entry.
+     * @return void.
+     */
+    static void freeImage(RCachedTexture *entry);
+
+    /**
+     * @brief deletes the entry's texture and takes it from the pixmaps drawing it.
+     * @param entry.
+     * @return void.
+     */
+    static void evict(RCachedTexture *entry);
+
+    /**
+     * @brief returns the registry. It's created on first use like RShaderCache's one.
+     * @param void.
+     * @return reference to the map of entries by path.
+     */
+    static std::map<std::string, RCachedTexture*>& entries();
+};
+}
+
+#endif // RTEXTURECACHE_H
@@ -0,0 +1,236 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RTextureFile.h"
+#include "RAssetPack.h"
+#include "RMipmapBuilder.h"
+//C++
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace Realio {
+namespace {
+const char MAGIC[4] = {'R', 'T', 'E', 'X'};
+const uint32_t VERSION = 1;
+const uint64_t LEVEL_ALIGNMENT = 16;
+// Largest edge 16 levels go down to 1x1 from, well within what an int and GL take
+const uint32_t MAX_SIZE = 1 << (RTextureFileHeader::MAX_LEVELS - 1);
+
+uint64_t alignUp(uint64_t offset)
+{
+    return (offset + LEVEL_ALIGNMENT - 1) / LEVEL_ALIGNMENT * LEVEL_ALIGNMENT;
+}
+
+int levelSize(int size, unsigned level)
+{
+    return std::max(1, size >> level);
+}
+}
+
+RTextureFile::RTextureFile()
+{
+    m_data = nullptr;
+    m_size = 0;
+    m_header = nullptr;
+}
+
+RTextureFile::~RTextureFile()
+{
+    close();
+}
+
+bool RTextureFile::open(const char *path)
+{
+    close();
+
+    // Stored entries of a pack are used in place, like a mapped file
+    size_t size = 0;
+    const unsigned char *stored = RAssetPack::map(path, size);
+    if(stored != nullptr)
+    {
+        m_data = stored;
+        m_size = size;
+    }
+    else if(RAssetPack::contains(path))
+    {
+        if(RAssetPack::read(path, m_buffer))
+        {
+            m_data = m_buffer.data();
+            m_size = m_buffer.size();
+        }
+    }
+    else if(m_file.open(path))
+    {
+        m_data = m_file.getData();
+        m_size = m_file.getSize();
+    }
+
+    if(m_data == nullptr || m_size < sizeof(RTextureFileHeader))
+    {
+        std::cerr << "Could not open texture file '" << path << "'" << std::endl;
+        close();
+        return false;
+    }
+
+    const RTextureFileHeader *header = (const RTextureFileHeader*)m_data;
+    bool valid = std::memcmp(header->magic, MAGIC, 4) == 0 &&
+                 header->version == VERSION && header->format == TEXTURE_RGBA8 &&
+                 header->width > 0 && header->height > 0 &&
+                 header->width <= MAX_SIZE && header->height <= MAX_SIZE &&
+                 header->levels > 0 && header->levels <= RTextureFileHeader::MAX_LEVELS;
+
+    for(unsigned i = 0; valid && i < header->levels; ++i)
+    {
+        uint64_t bytes = (uint64_t)levelSize(header->width, i) * levelSize(header->height, i) * 4;
+        // Compared by what's left, so a huge offset can't wrap around
+        valid = header->offsets[i] % 4 == 0 && header->offsets[i] <= m_size &&
+                bytes <= m_size - header->offsets[i];
+    }
+
+    if(!valid)
+    {
+        std::cerr << "Could not open texture file '" << path << "': bad header" << std::endl;
+        close();
+        return false;
+    }
+
+    m_header = header;
+    return true;
+}
+
+void RTextureFile::close()
+{
+    m_file.close();
+    m_buffer.clear();
+    m_data = nullptr;
+    m_size = 0;
+    m_header = nullptr;
+}
+
+int RTextureFile::getWidth()
+{
+    return m_header != nullptr ? m_header->width : 0;
+}
+
+int RTextureFile::getHeight()
+{
+    return m_header != nullptr ? m_header->height : 0;
+}
+
+unsigned RTextureFile::getLevels()
+{
+    return m_header != nullptr ? m_header->levels : 0;
+}
+
+bool RTextureFile::isOpaque()
+{
+    return m_header != nullptr && (m_header->flags & TEXTURE_OPAQUE) == TEXTURE_OPAQUE;
+}
+
+const unsigned char* RTextureFile::getLevel(unsigned level, int &width, int &height)
+{
+    if(m_header == nullptr || level >= m_header->levels)
+        return nullptr;
+
+    width = levelSize(m_header->width, level);
+    height = levelSize(m_header->height, level);
+    return m_data + m_header->offsets[level];
+}
+
+size_t RTextureFile::getSize()
+{
+    return m_size;
+}
+
+/*static*/ bool RTextureFile::isTextureFile(const char *path)
+{
+    std::vector<unsigned char> magic;
+    if(!RAssetPack::read(path, magic, 4))
+        return false;
+
+    return magic.size() == 4 && std::memcmp(magic.data(), MAGIC, 4) == 0;
+}
+
+/*static*/ bool RTextureFile::write(const char *path, const unsigned char *image, int width, int height)
+{
+    if(width <= 0 || height <= 0 || (uint32_t)width > MAX_SIZE || (uint32_t)height > MAX_SIZE)
+    {
+        std::cerr << "Could not write texture file '" << path << "': bad size "
+                  << width << "x" << height << std::endl;
+        return false;
+    }
+
+    RTextureFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, 4);
+    header.version = VERSION;
+    header.format = TEXTURE_RGBA8;
+    header.width = width;
+    header.height = height;
+
+    header.flags = TEXTURE_OPAQUE;
+    for(int i = 0; i < width * height; ++i)
+    {
+        if(image[i * 4 + 3] != 255)
+        {
+            header.flags &= ~TEXTURE_OPAQUE;
+            break;
+        }
+    }
+
+    // Every level down to 1x1, the same as loaders build them
+    RMipChain *chain = RMipmapBuilder::build(image, width, height);
+
+    std::vector<const unsigned char*> levels(1, image);
+    std::vector<size_t> sizes(1, (size_t)width * height * 4);
+    for(unsigned i = 0; i < chain->levels.size() && levels.size() < RTextureFileHeader::MAX_LEVELS; ++i)
+    {
+        levels.push_back(chain->pixels.data() + chain->levels[i].offset);
+        sizes.push_back((size_t)chain->levels[i].width * chain->levels[i].height * 4);
+    }
+    header.levels = levels.size();
+
+    uint64_t offset = alignUp(sizeof(header));
+    for(unsigned i = 0; i < levels.size(); ++i)
+    {
+        header.offsets[i] = offset;
+        offset = alignUp(offset + sizes[i]);
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if(!file)
+    {
+        std::cerr << "Could not write texture file '" << path << "'" << std::endl;
+        RMipmapBuilder::destroy(chain);
+        return false;
+    }
+
+    file.write((const char*)&header, sizeof(header));
+    for(unsigned i = 0; i < levels.size(); ++i)
+    {
+        // Pad up to the level's offset
+        std::vector<char> padding(header.offsets[i] - file.tellp(), 0);
+        file.write(padding.data(), padding.size());
+        file.write((const char*)levels[i], sizes[i]);
+    }
+
+    RMipmapBuilder::destroy(chain);
+    return (bool)file;
+}
+}
@@ -0,0 +1,144 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RTEXTUREFILE_H
+#define RTEXTUREFILE_H
+
+//Realio
+#include "RMappedFile.h"
+//C++
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Realio {
+//Pixel formats of texture files
+typedef enum
+{
+    TEXTURE_RGBA8 = 0                         //8 bits per channel, rows from the top
+} RTextureFormat;
+
+//Flags of texture files
+typedef enum
+{
+    TEXTURE_OPAQUE = 0x00000001               //No transparent pixels
+} RTextureFlag;
+
+// Laid out as stored, little endian. Levels follow at 16 byte aligned offsets.
+struct RTextureFileHeader
+{
+    static const unsigned MAX_LEVELS = 16;
+
+    char magic[4];
+    uint32_t version;
+    uint32_t format;
+    uint32_t width, height;
+    uint32_t levels;
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t offsets[MAX_LEVELS];
+};
+
+class RTextureFile
+{
+public:
+    RTextureFile();
+    ~RTextureFile();
+
+    /**
+     * @brief maps the file into memory and checks its header.
+     * Nothing is decoded, levels are read straight from the mapping.
+     * Files in a mounted RAssetPack are taken from the pack.
+     * @param path to the file.
+     * @return true, if the file is a valid texture. false, if not.
+     */
+    bool open(const char *path);
+
+    /**
+     * @brief unmaps the file.
+     * @param void.
+     * @return void.
+     */
+    void close();
+
+    /**
+     * @brief returns width of the base level.
+     * @param void.
+     * @return width in pixels.
+     */
+    int getWidth();
+
+    /**
+     * @brief returns height of the base level.
+     * @param void.
+     * @return height in pixels.
+     */
+    int getHeight();
+
+    /**
+     * @brief returns number of stored levels, the base one included.
+     * @param void.
+     * @return number of levels.
+     */
+    unsigned getLevels();
+
+    /**
+     * @brief returns true, if the texture has no transparent pixels.
+     * @param void.
+     * @return true, if it's opaque. false, if not.
+     */
+    bool isOpaque();
+
+    /**
+     * @brief returns pixels of the level.
+     * @param index of the level and places for its size.
+     * @return pointer into the mapping, nullptr if there is no such level.
+     */
+    const unsigned char* getLevel(unsigned level, int &width, int &height);
+
+    /**
+     * @brief returns size of the mapped file.
+     * @param void.
+     * @return number of bytes.
+     */
+    size_t getSize();
+
+    /**
+     * @brief returns true, if the file starts with the texture file's magic.
+     * @param path to the file.
+     * @return true, if it's a texture file. false, if not.
+     */
+    static bool isTextureFile(const char *path);
+
+    /**
+     * @brief writes an RGBA image with its whole mip chain built by RMipmapBuilder.
+     * @param path to the file, image and its size.
+     * @return true, if the file is written. false, if not.
+     */
+    static bool write(const char *path, const unsigned char *image, int width, int height);
+
+private:
+    const unsigned char *m_data;
+    size_t m_size;
+    // Loose files are mapped, compressed packed ones are unpacked here
+    RMappedFile m_file;
+    std::vector<unsigned char> m_buffer;
+
+    const RTextureFileHeader *m_header;
+};
+}
+
+#endif // RTEXTUREFILE_H
@@ -0,0 +1,306 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+//Realio
+#include "RTextureUploader.h"
+#include "RGLState.h"
+#include "RMemoryTracker.h"
+#include "RMipmapBuilder.h"
+#include "RPixmap.h"
+#include "RProfiler.h"
+#include "RTextureCache.h"
+#include "RTextureFile.h"
+//C++
+#include <algorithm>
+#include <cstring>
+#include <vector>
+//STB
+#include "stb/stb_image.h"
+
+namespace Realio {
+std::deque<RTextureUploader::Job> RTextureUploader::m_jobs;
+RStreamBuffer *RTextureUploader::m_stream = nullptr;
+bool RTextureUploader::m_enabled = false;
+size_t RTextureUploader::m_byteBudget = 4 * 1024 * 1024;
+double RTextureUploader::m_timeBudget = 2.0;
+unsigned RTextureUploader::m_nextTicket = 1;
+
+/*static*/ void RTextureUploader::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+}
+
+/*static*/ bool RTextureUploader::isEnabled()
+{
+    return m_enabled;
+}
+
+/*static*/ void RTextureUploader::setBudget(size_t bytes, double milliseconds)
+{
+    m_byteBudget = bytes;
+    m_timeBudget = milliseconds;
+}
+
+/*static*/ unsigned RTextureUploader::enqueue(RPixmap *pixmap, const unsigned char *image, int width, int height,
+                                              RMipChain *mips)
+{
+    Job job;
+    job.ticket = m_nextTicket++;
+    job.pixmap = pixmap;
+    job.entry = nullptr;
+    job.image = image;
+    job.file = nullptr;
+    job.mips = mips;
+    job.level = 0;
+    job.pixels = image;
+    job.width = width;
+    job.height = height;
+    job.row = 0;
+    job.texture = 0;
+
+    m_jobs.push_back(job);
+    return job.ticket;
+}
+
+/*static*/ unsigned RTextureUploader::enqueue(RCachedTexture *entry)
+{
+    unsigned ticket = enqueue(nullptr, entry->image, entry->width, entry->height, entry->mips);
+    m_jobs.back().entry = entry;
+    m_jobs.back().file = entry->file;
+
+    return ticket;
+}
+
+/*static*/ void RTextureUploader::cancel(unsigned ticket)
+{
+    for(unsigned i = 0; i < m_jobs.size(); ++i)
+    {
+        if(m_jobs[i].ticket != ticket)
+            continue;
+
+        freeImage(m_jobs[i]);
+        if(m_jobs[i].texture)
+            RGLState::deleteTexture(m_jobs[i].texture);
+
+        m_jobs.erase(m_jobs.begin() + i);
+        return;
+    }
+}
+
+/*static*/ unsigned RTextureUploader::process()
+{
+    if(m_jobs.empty())
+        return 0;
+
+    REALIO_PROFILE_ZONE("RTextureUploader::process");
+
+    uint64_t start = RProfiler::now();
+    size_t budget = m_byteBudget;
+    bool worked = false;
+
+    std::vector<Job> finished;
+
+    while(!m_jobs.empty())
+    {
+        // Something is done every frame, so a tiny budget still makes progress
+        double elapsed = (RProfiler::now() - start) / 1000000.0;
+        if(worked && (elapsed >= m_timeBudget || budget == 0))
+            break;
+
+        Job &job = m_jobs.front();
+        if(!job.texture)
+            allocate(job);
+
+        if(job.row < job.height)
+        {
+            size_t rowBytes = (size_t)job.width * 4;
+            int rows = std::min<size_t>(budget / rowBytes, job.height - job.row);
+            if(rows == 0)
+            {
+                if(worked)
+                    break;
+                rows = 1;
+            }
+
+            size_t copied = copyRows(job, rows);
+            if(copied == 0)
+                break;
+
+            budget -= std::min(budget, copied);
+            worked = true;
+            continue;
+        }
+
+        // Stored mipmaps are copied like the base level
+        if(job.level + 1 < getLevelCount(job))
+        {
+            job.level++;
+            job.pixels = getMipmap(job, job.level, job.width, job.height);
+            job.row = 0;
+            continue;
+        }
+
+        // Others are generated in one go, but not in the frame of a big copy
+        if(job.file == nullptr && job.mips == nullptr)
+        {
+            if(worked && budget < m_byteBudget / 2)
+                break;
+
+            RGLState::bindTexture(job.texture);
+            glGenerateMipmap(GL_TEXTURE_2D);
+            worked = true;
+        }
+
+        freeImage(job);
+        finished.push_back(job);
+        m_jobs.pop_front();
+    }
+
+    if(m_stream != nullptr)
+        m_stream->nextFrame();
+
+    // Pixmaps may queue or cancel uploads, so call them with the queue settled
+    for(unsigned i = 0; i < finished.size(); ++i)
+    {
+        if(finished[i].pixmap != nullptr)
+            finished[i].pixmap->textureUploaded(finished[i].ticket, finished[i].texture);
+        else
+            RTextureCache::uploaded(finished[i].entry, finished[i].texture);
+    }
+
+    return finished.size();
+}
+
+/*static*/ unsigned RTextureUploader::getPendingCount()
+{
+    return m_jobs.size();
+}
+
+/*static*/ void RTextureUploader::shutdown()
+{
+    while(!m_jobs.empty())
+        cancel(m_jobs.front().ticket);
+
+    delete m_stream;
+    m_stream = nullptr;
+}
+
+/*static*/ void RTextureUploader::allocate(Job &job)
+{
+    glGenTextures(1, &job.texture);
+    RGLState::bindTexture(job.texture);
+
+    // Set texture parameters
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    // Set texture filtering, the mip chain is sampled however it's built
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // Storage only, the rows come later
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, job.width, job.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    unsigned levels = getLevelCount(job);
+    if(levels > 1)
+    {
+        for(unsigned i = 1; i < levels; ++i)
+        {
+            int width, height;
+            getMipmap(job, i, width, height);
+            glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        }
+        // Sampling an incomplete chain would give black
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    }
+
+    RMemoryTracker::allocate(MEMORY_TEXTURES, job.texture,
+                             RMemoryTracker::textureSize(job.width, job.height, 4, true),
+                             job.pixmap != nullptr ? job.pixmap->getID() : 0);
+}
+
+/*static*/ unsigned RTextureUploader::getLevelCount(Job &job)
+{
+    if(job.file != nullptr)
+        return job.file->getLevels();
+    if(job.mips != nullptr)
+        return job.mips->levels.size() + 1;
+
+    return 1;
+}
+
+/*static*/ const unsigned char* RTextureUploader::getMipmap(Job &job, unsigned level, int &width, int &height)
+{
+    if(job.file != nullptr)
+        return job.file->getLevel(level, width, height);
+
+    const RMipLevel &mipmap = job.mips->levels[level - 1];
+    width = mipmap.width;
+    height = mipmap.height;
+    return job.mips->pixels.data() + mipmap.offset;
+}
+
+/*static*/ size_t RTextureUploader::copyRows(Job &job, int rows)
+{
+    GLsizeiptr size = (GLsizeiptr)job.width * 4 * rows;
+
+    // A row wider than the budget grows the buffer instead of failing
+    if(m_stream == nullptr || size > m_stream->getSegmentSize())
+    {
+        GLsizeiptr segmentSize = std::max<GLsizeiptr>(size, m_byteBudget);
+        delete m_stream;
+        m_stream = new RStreamBuffer(GL_PIXEL_UNPACK_BUFFER, segmentSize);
+    }
+
+    GLintptr offset = 0;
+    void *memory = m_stream->map(size, 4, offset);
+    if(memory == nullptr)
+        return 0;
+
+    std::memcpy(memory, job.pixels + (size_t)job.row * job.width * 4, size);
+    m_stream->unmap();
+
+    RGLState::bindTexture(job.texture);
+    RGLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, m_stream->getBuffer());
+    glTexSubImage2D(GL_TEXTURE_2D, job.level, 0, job.row, job.width, rows, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)offset);
+    // Other uploads pass client memory, which a bound unpack buffer would break
+    RGLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    RGLState::countTextureUpload(size);
+    job.row += rows;
+
+    return size;
+}
+
+/*static*/ void RTextureUploader::freeImage(Job &job)
+{
+    if(job.file != nullptr)
+    {
+        RMemoryTracker::release(MEMORY_DECODED_IMAGES, (uintptr_t)job.file);
+        delete job.file;
+    }
+    else if(job.image)
+    {
+        RMemoryTracker::release(MEMORY_DECODED_IMAGES, (uintptr_t)job.image);
+        stbi_image_free((void*)job.image);
+    }
+    RMipmapBuilder::destroy(job.mips);
+
+    job.image = nullptr;
+    job.file = nullptr;
+    job.mips = nullptr;
+    job.pixels = nullptr;
+}
+}
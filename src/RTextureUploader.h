@@ -0,0 +1,172 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#ifndef RTEXTUREUPLOADER_H
+#define RTEXTUREUPLOADER_H
+
+//Realio
+#include "RStreamBuffer.h"
+//C++
+#include <cstddef>
+#include <deque>
+//GLEW
+#include <GL/glew.h>
+
+namespace Realio {
+class RPixmap;
+class RTextureFile;
+struct RCachedTexture;
+struct RMipChain;
+
+class RTextureUploader
+{
+public:
+    /**
+     * @brief makes pixmaps stream their textures instead of uploading them
+     * at once in show(). It's off by default.
+     * @param true to stream, false to upload at once.
+     * @return void.
+     */
+    static void setEnabled(bool enabled);
+
+    /**
+     * @brief returns true, if textures are streamed.
+     * @param void.
+     * @return true, if streaming is on. false, if not.
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief sets how much process() may do per frame. At least one row
+     * or one mipmap generation is done every frame anyway.
+     * @param bytes copied to textures and milliseconds spent on the CPU.
+     * @return void.
+     */
+    static void setBudget(size_t bytes, double milliseconds);
+
+    /**
+     * @brief queues an RGBA image for uploading to a new texture. The
+     * uploader takes the image and its mipmaps and frees them, when they're uploaded.
+     * @param pixmap waiting for the texture, image, its size and mipmaps built
+     * by RMipmapBuilder (nullptr to generate them on the GPU).
+     * @return ticket of the upload.
+     */
+    static unsigned enqueue(RPixmap *pixmap, const unsigned char *image, int width, int height,
+                            RMipChain *mips = nullptr);
+
+    /**
+     * @brief queues the cached entry's image, which the uploader takes.
+     * A texture file or built mipmaps are taken too and all levels are streamed.
+     * The finished texture goes to RTextureCache::uploaded().
+     * @param entry.
+     * @return ticket of the upload.
+     */
+    static unsigned enqueue(RCachedTexture *entry);
+
+    /**
+     * @brief drops the upload with its texture and image.
+     * @param ticket of the upload.
+     * @return void.
+     */
+    static void cancel(unsigned ticket);
+
+    /**
+     * @brief streams queued images through a pixel unpack buffer within the
+     * budget and gives finished textures to their pixmaps. Call it once a frame.
+     * @param void.
+     * @return number of finished textures.
+     */
+    static unsigned process();
+
+    /**
+     * @brief returns number of unfinished uploads.
+     * @param void.
+     * @return number of uploads.
+     */
+    static unsigned getPendingCount();
+
+    /**
+     * @brief drops all uploads and the unpack buffer. Call it before the
+     * context is destroyed.
+     * @param void.
+     * @return void.
+     */
+    static void shutdown();
+
+private:
+    struct Job {
+        unsigned ticket;
+        // Either a pixmap or a cached entry waits for the texture
+        RPixmap *pixmap;
+        RCachedTexture *entry;
+        // Decoded image, unless a texture file owns the pixels
+        const unsigned char *image;
+        RTextureFile *file;
+        RMipChain *mips;
+        // Level being copied, its pixels and its size
+        unsigned level;
+        const unsigned char *pixels;
+        int width, height;
+        // Next row to copy, height when only mipmaps are left
+        int row;
+        GLuint texture;
+    };
+
+    static std::deque<Job> m_jobs;
+    static RStreamBuffer *m_stream;
+    static bool m_enabled;
+    static size_t m_byteBudget;
+    static double m_timeBudget;
+    static unsigned m_nextTicket;
+
+    /**
+     * @brief creates the job's texture with storage for all levels.
+     * @param job.
+     * @return void.
+     */
+    static void allocate(Job &job);
+
+    /**
+     * @brief returns number of levels the job copies, 1 if the GPU generates mipmaps.
+     * @param job.
+     * @return number of levels.
+     */
+    static unsigned getLevelCount(Job &job);
+
+    /**
+     * @brief returns pixels of the job's stored mipmap.
+     * @param job, level from 1 on and places for its size.
+     * @return pointer to the level's pixels.
+     */
+    static const unsigned char* getMipmap(Job &job, unsigned level, int &width, int &height);
+
+    /**
+     * @brief copies rows of the job's level through the unpack buffer.
+     * @param job and number of rows.
+     * @return number of copied bytes.
+     */
+    static size_t copyRows(Job &job, int rows);
+
+    /**
+     * @brief frees the job's image or its texture file and its mipmaps, if there are ones.
+     * @param job.
+     * @return void.
+     */
+    static void freeImage(Job &job);
+};
+}
+
+#endif // RTEXTUREUPLOADER_H
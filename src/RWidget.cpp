@@ -17,6 +17,9 @@
 //Realio
 #include "RWidget.h"
 #include "RWidget_global.h"
+#include "RRenderQueue.h"
+#include "RSpriteBatch.h"
+#include "RWindow.h"
 
 namespace Realio {
 RWidget::RWidget(
@@ -30,14 +33,20 @@ RWidget::RWidget(
     m_width = w;
     m_height = h;
 
-    m_moved, m_resized = false;
+    m_moved = m_resized = false;
+    m_dirty = true;
+    m_quad = nullptr;
+    m_window = nullptr;
+    m_layer = 0;
 
     m_id = generateID();
 }
 
 RWidget::~RWidget()
 {
-
+    // Don't leave the window drawing a dangling pointer
+    if(m_window != nullptr)
+        m_window->deleteWidget(m_id);
 }
 
 void RWidget::move(const int x, const int y)
@@ -72,6 +81,7 @@ void RWidget::resize(const int w, const int h)
 void RWidget::scale(float ratio)
 {
     R3DObject::scale(ratio);
+    m_resized = true;
 }
 
 int RWidget::getWidth()
@@ -94,6 +104,62 @@ int RWidget::getID()
 
 }
 
+/*virtual*/ void RWidget::submit(RSpriteBatch *batch)
+{
+    batch->flush();
+    update();
+}
+
+/*virtual*/ void RWidget::enqueue(RRenderQueue *queue)
+{
+    queue->push(this, m_layer, 0, 0);
+}
+
+/*virtual*/ void RWidget::keepResident()
+{
+}
+
+void RWidget::setLayer(const int layer)
+{
+    m_layer = layer;
+    m_dirty = true;
+}
+
+int RWidget::getLayer()
+{
+    return m_layer;
+}
+
+void RWidget::markDirty()
+{
+    m_dirty = true;
+}
+
+bool RWidget::isDirty()
+{
+    return m_dirty || m_moved || m_resized;
+}
+
+void RWidget::clearDirty()
+{
+    m_dirty = m_moved = m_resized = false;
+}
+
+glm::mat4 RWidget::getTransform()
+{
+    return m_modelMatrix * getQuadMatrix();
+}
+
+glm::mat4 RWidget::getQuadMatrix()
+{
+    float width = float(2 * m_width) / float(m_winWidth);
+    float height = float(2 * m_height) / float(m_winHeight);
+
+    // The widget's quad starts at the top left corner of the window
+    glm::mat4 quad = glm::translate(glm::mat4(), glm::vec3(-1.0f, 1.0f - height, 0.0f));
+    return glm::scale(quad, glm::vec3(width, height, 1.0f));
+}
+
 /*virtual*/ void RWidget::show()
 {
 
@@ -110,4 +176,14 @@ void RWidget::setWindowSize(int w, int h)
 
     move(x, y);
 }
+
+void RWidget::setQuad(RQuad *quad)
+{
+    m_quad = quad;
+}
+
+void RWidget::setWindow(RWindow *window)
+{
+    m_window = window;
+}
 }
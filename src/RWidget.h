@@ -19,13 +19,18 @@
 
 //Realio
 #include "R3DObject.h"
+#include "RQuad.h"
 
 namespace Realio {
+class RRenderQueue;
+class RSpriteBatch;
+class RWindow;
+
 class RWidget : protected R3DObject
 {
 public:
     RWidget(const int x, const int y, const int w, const int h);
-    ~RWidget();
+    virtual ~RWidget();
 
     /**
      * @brief sets widget's position on a window to x and y.
@@ -90,6 +95,21 @@ public:
      */
     void setWindowSize(int w, int h);
 
+    /**
+     * @brief sets the quad shared by all widgets of the window.
+     * @param pointer to the window's RQuad.
+     * @return void.
+     */
+    void setQuad(RQuad *quad);
+
+    /**
+     * @brief sets the window the widget was added to. The widget leaves it
+     * when it's destroyed.
+     * @param pointer to the RWindow or nullptr.
+     * @return void.
+     */
+    void setWindow(RWindow *window);
+
     /**
      * @brief shows up the widget.
      * @param void.
@@ -104,6 +124,83 @@ public:
      */
     virtual void update();
 
+    /**
+     * @brief draws the widget through the sprite batch.
+     * Widgets, which can't be batched, flush it and draw themselves.
+     * @param pointer to the window's sprite batch.
+     * @return void.
+     */
+    virtual void submit(RSpriteBatch *batch);
+
+    /**
+     * @brief submits the widget to the window's render queue.
+     * @param pointer to the window's render queue.
+     * @return void.
+     */
+    virtual void enqueue(RRenderQueue *queue);
+
+    /**
+     * @brief called by the window every frame the widget is on the screen,
+     * so it can keep or restore textures, which are evicted otherwise.
+     * @param void.
+     * @return void.
+     */
+    virtual void keepResident();
+
+    /**
+     * @brief sets the widget's layer. Higher layers are drawn over lower ones.
+     * Overlapping widgets of the same layer are drawn in the order they were
+     * added, others may be regrouped by program and texture.
+     * @param layer from -128 to 127.
+     * @return void.
+     */
+    void setLayer(const int layer);
+
+    /**
+     * @brief returns the widget's layer.
+     * @param void.
+     * @return layer.
+     */
+    int getLayer();
+
+    /**
+     * @brief marks the widget's content as changed, so the window redraws it.
+     * Moving, resizing and scaling mark the widget too.
+     * @param void.
+     * @return void.
+     */
+    void markDirty();
+
+    /**
+     * @brief returns true if the widget has changed since it was drawn last time.
+     * @param void.
+     * @return true, if the widget has to be redrawn. false, if not.
+     */
+    bool isDirty();
+
+    /**
+     * @brief forgets the widget's changes. The window calls it after drawing.
+     * @param void.
+     * @return void.
+     */
+    void clearDirty();
+
+    /**
+     * @brief returns the matrix, which maps the unit quad onto the widget
+     * in the window's normalized coordinates.
+     * @param void.
+     * @return 4x4 matrix from GLM.
+     */
+    glm::mat4 getTransform();
+
+    /**
+     * @brief returns the matrix, which maps the unit quad onto the widget's
+     * size at the top left corner of the window.
+     * @param void.
+     * @return 4x4 matrix from GLM.
+     */
+    glm::mat4 getQuadMatrix();
+
 protected:
     unsigned m_id;
     int m_xPos; // Top left angle positions
@@ -112,8 +209,13 @@ protected:
     int m_height;
     int m_winWidth;
     int m_winHeight;
+    int m_layer;
     bool m_moved;
     bool m_resized;
+    bool m_dirty;
+
+    RQuad *m_quad;
+    RWindow *m_window;
 };
 }
 
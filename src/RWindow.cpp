@@ -16,16 +16,123 @@
 
 //Realio
 #include "RWindow.h"
+#include "RAssetPack.h"
+#include "RGLState.h"
+#include "RImageLoader.h"
+#include "RMemoryTracker.h"
+#include "RMipmapBuilder.h"
+#include "RProfiler.h"
+#include "RTextureAtlas.h"
+#include "RTextureCache.h"
+#include "RTextureUploader.h"
 //C++
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 
 namespace Realio {
+namespace {
+// More rectangles than that are redrawn as one
+const unsigned MAX_DAMAGE_RECTS = 8;
+
+// Types of m_customCursors' slots
+const Uint32 customCursorTypes[4] = {CURSOR_ARROW, CURSOR_IBEAM, CURSOR_WAIT, CURSOR_HAND};
+
+/**
+ * @brief returns the window's rectangle covered by the transformed unit quad.
+ * @param transform of the quad and size of the window.
+ * @return rectangle with top left origin, empty if the quad is out of the window.
+ */
+SDL_Rect projectRect(const glm::mat4 &transform, int width, int height)
+{
+    SDL_Rect window = {0, 0, width, height};
+    float minX = 1.0f, minY = 1.0f, maxX = -1.0f, maxY = -1.0f;
+
+    for(unsigned i = 0; i < 4; ++i)
+    {
+        glm::vec4 clip = transform * glm::vec4(RQuad::vertices[i * 5], RQuad::vertices[i * 5 + 1], 0.0f, 1.0f);
+
+        // The quad crosses the camera's plane
+        if(clip.w <= 0.0f)
+            return window;
+
+        minX = std::min(minX, clip.x / clip.w);
+        maxX = std::max(maxX, clip.x / clip.w);
+        minY = std::min(minY, clip.y / clip.w);
+        maxY = std::max(maxY, clip.y / clip.w);
+    }
+
+    // A pixel around covers linear filtering
+    int left = (int)std::floor((minX + 1.0f) * 0.5f * width) - 1;
+    int right = (int)std::ceil((maxX + 1.0f) * 0.5f * width) + 1;
+    int top = (int)std::floor((1.0f - maxY) * 0.5f * height) - 1;
+    int bottom = (int)std::ceil((1.0f - minY) * 0.5f * height) + 1;
+
+    SDL_Rect rect = {left, top, right - left, bottom - top};
+    SDL_Rect visible = {0, 0, 0, 0};
+    SDL_IntersectRect(&rect, &window, &visible);
+
+    return visible;
+}
+}
+
 RWindow::RWindow(const std::string & title = "")
 {
     m_window = nullptr;
     m_surface = nullptr;
 
     m_title = title;
+    m_headless = false;
+    m_width = m_height = 0;
+
+    // Lets unchanged programs run on machines without a display
+    const char *headless = std::getenv("REALIO_HEADLESS");
+    if(headless != nullptr)
+    {
+        m_headless = true;
+        if(std::sscanf(headless, "%dx%d", &m_width, &m_height) != 2)
+            m_width = m_height = 0;
+    }
+
+    initialize();
+}
+
+RWindow::RWindow(const std::string & title, const int width, const int height,
+                 const RWindowMode mode)
+{
+    m_window = nullptr;
+    m_surface = nullptr;
+
+    m_title = title;
+    m_headless = mode == WINDOW_HEADLESS;
+    m_width = width;
+    m_height = height;
+
+    initialize();
+}
+
+void RWindow::initialize()
+{
+    m_frames = 0;
+    m_frameLimit = 0;
+
+    const char *frameLimit = std::getenv("REALIO_FRAME_LIMIT");
+    if(frameLimit != nullptr)
+        m_frameLimit = std::strtoul(frameLimit, nullptr, 10);
+
+    // Budget of cached textures in MiB
+    const char *textureBudget = std::getenv("REALIO_TEXTURE_BUDGET");
+    if(textureBudget != nullptr)
+        RTextureCache::setBudget(std::strtoul(textureBudget, nullptr, 10) * 1024 * 1024);
+
+    // Mounted before anything is loaded, so even the first images come from the pack
+    const char *assetPack = std::getenv("REALIO_ASSET_PACK");
+    if(assetPack != nullptr)
+        RAssetPack::mount(assetPack);
+
+    if(std::getenv("REALIO_CPU_MIPMAPS") != nullptr)
+        RMipmapBuilder::setEnabled(true);
 
     if(!initializeSDL())
     {
@@ -36,25 +143,91 @@ RWindow::RWindow(const std::string & title = "")
 
     glewExperimental = GL_TRUE;
     glewInit();
+    RGLState::invalidate();
 
     glViewport(0, 0, m_width, m_height);
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
     // Enable blending
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_BLEND);
+    RGLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    RGLState::setBlending(true);
+
+    m_quad = new RQuad;
+    m_batch = new RSpriteBatch(m_quad);
+    m_batching = true;
+    m_queue = new RRenderQueue;
+
+    m_camera = nullptr;
+    m_cameraBuffer = new RCameraBuffer;
+    // Identity matrices for the cursor, uploaded once
+    m_cursorBuffer = new RCameraBuffer;
+    m_cursorBuffer->update(nullptr, (float)m_width / m_height);
+
+    m_target = new RRenderTarget(m_width, m_height);
+    if(!m_target->isComplete())
+    {
+        delete m_target;
+        m_target = nullptr;
+
+        // There is nothing else to draw to
+        if(m_headless)
+        {
+            std::cerr << "Exiting.\n";
+            SDL_Quit();
+            std::exit(1);
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    m_damageTracking = true;
+    m_fullRedraw = true;
+    m_frameSkipped = false;
+
+    m_capture = nullptr;
+    m_gpuTimer = new RGPUTimer;
+    m_history = new RFrameHistory;
 
     quit = false;
     m_cursorType = CURSOR_ARROW;
+    callback = nullptr;
 }
 
 RWindow::~RWindow()
 {
+    // Lets unchanged programs record a trace
+    const char *trace = std::getenv("REALIO_TRACE");
+    if(trace != nullptr)
+        RProfiler::writeTrace(trace);
+
+    // Unfinished loads are dropped, the placeholder goes with the context
+    RImageLoader::stop();
+    RTextureUploader::shutdown();
+
     for(unsigned i = 0; i < 4; ++i)
         if(m_customCursors[i] != nullptr)
             delete m_customCursors[i];
 
+    // Widgets outliving the window have nothing to leave
+    for(unsigned i = 0; i < m_widgets.size(); ++i)
+        m_widgets[i]->setWindow(nullptr);
+
+    delete m_history;
+    delete m_gpuTimer;
+    delete m_target;
+    delete m_cameraBuffer;
+    delete m_cursorBuffer;
+    delete m_queue;
+    delete m_batch;
+    delete m_quad;
+
+    // Anything left is owned by widgets still alive or leaked
+    size_t left = RMemoryTracker::getTotalBytes();
+    if(left > 0)
+        std::cerr << "Realio: " << left << " bytes are still in use on shutdown" << std::endl;
+    if(left > 0 || std::getenv("REALIO_MEMORY_REPORT") != nullptr)
+        RMemoryTracker::report(std::cerr);
+
     SDL_GL_DeleteContext(m_context);
     SDL_Quit();
 }
@@ -63,7 +236,11 @@ bool RWindow::initializeSDL()
 {
     SDL_DisplayMode current;
 
-    if(SDL_Init(SDL_INIT_EVERYTHING) < 0)
+    // The offscreen driver creates GL contexts through EGL without a display
+    if(m_headless)
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "offscreen");
+
+    if(SDL_Init(m_headless ? SDL_INIT_VIDEO : SDL_INIT_EVERYTHING) < 0)
     {
         std::cerr << "Could not initialize SDL: " << SDL_GetError();
         std::cerr << std::endl;
@@ -74,7 +251,11 @@ bool RWindow::initializeSDL()
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
 
-    if(SDL_GetCurrentDisplayMode(0, &current) != 0)
+    if(m_width > 0 && m_height > 0)
+    {
+        // The size is given by the user
+    }
+    else if(SDL_GetCurrentDisplayMode(0, &current) != 0)
     {
         // In case of error...
         std::cerr << "Could not get display mode for video display: ";
@@ -88,14 +269,16 @@ bool RWindow::initializeSDL()
         m_height = current.h;
     }
 
+    Uint32 flags = SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN;
+    if(!m_headless)
+        flags |= SDL_WINDOW_FULLSCREEN_DESKTOP;
+
     m_window = SDL_CreateWindow(
                 m_title.data(),
                 SDL_WINDOWPOS_UNDEFINED,
                 SDL_WINDOWPOS_UNDEFINED,
                 m_width, m_height,
-                SDL_WINDOW_OPENGL |
-                SDL_WINDOW_FULLSCREEN_DESKTOP |
-                SDL_WINDOW_HIDDEN);
+                flags);
 
     if(m_window == nullptr)
     {
@@ -107,6 +290,13 @@ bool RWindow::initializeSDL()
     m_surface = SDL_GetWindowSurface(m_window);
     m_context = SDL_GL_CreateContext(m_window);
 
+    if(m_context == nullptr)
+    {
+        std::cerr << "Could not create GL context: " << SDL_GetError();
+        std::cerr << std::endl;
+        return false;
+    }
+
     //Init cursors
     m_systemCursors[0] = SDL_CreateSystemCursor(SDL_SYSTEM_CURSOR_ARROW);
     m_systemCursors[1] = SDL_CreateSystemCursor(SDL_SYSTEM_CURSOR_IBEAM);
@@ -123,7 +313,10 @@ bool RWindow::initializeSDL()
 void RWindow::show()
 {
     m_shown = true;
-    SDL_ShowWindow(m_window);
+    m_fullRedraw = true;
+
+    if(!m_headless)
+        SDL_ShowWindow(m_window);
 }
 
 void RWindow::close()
@@ -151,39 +344,33 @@ std::string RWindow::getTitle()
 
 void RWindow::setCursor(const char *filename, const Uint32 type)
 {
-    if ((type & CURSOR_ARROW) == CURSOR_ARROW)
-    {
-        if(m_customCursors[0] == nullptr)
-            m_customCursors[0] = new RPixmap;
-        m_customCursors[0]->loadFile(filename);
-        m_customCursors[0]->setWindowSize(m_width, m_height);
-    }
-    if ((type & CURSOR_IBEAM) == CURSOR_IBEAM)
-    {
-        if(m_customCursors[1] == nullptr)
-            m_customCursors[1] = new RPixmap;
-        m_customCursors[1]->loadFile(filename);
-        m_customCursors[1]->setWindowSize(m_width, m_height);
-    }
-    if ((type & CURSOR_WAIT) == CURSOR_WAIT)
-    {
-        if(m_customCursors[2] == nullptr)
-            m_customCursors[2] = new RPixmap;
-        m_customCursors[2]->loadFile(filename);
-        m_customCursors[2]->setWindowSize(m_width, m_height);
-    }
-    if ((type & CURSOR_HAND) == CURSOR_HAND)
+    m_fullRedraw = true;
+
+    // Cursors of one file share its image and texture through RTextureCache
+    for(unsigned i = 0; i < 4; ++i)
     {
-        if(m_customCursors[3] == nullptr)
-            m_customCursors[3] = new RPixmap;
-        m_customCursors[3]->loadFile(filename);
-        m_customCursors[3]->setWindowSize(m_width, m_height);
+        if((type & customCursorTypes[i]) != customCursorTypes[i])
+            continue;
+
+        if(m_customCursors[i] == nullptr)
+            m_customCursors[i] = new RPixmap;
+        m_customCursors[i]->loadFile(filename);
+        m_customCursors[i]->setWindowSize(m_width, m_height);
+        m_customCursors[i]->setQuad(m_quad);
     }
 }
 
+void RWindow::packCursors(RTextureAtlas *atlas)
+{
+    for(unsigned i = 0; i < 4; ++i)
+        if(m_customCursors[i] != nullptr && m_customCursors[i]->getImage() != nullptr)
+            atlas->addPixmap(m_customCursors[i]);
+}
+
 void RWindow::setCurrentCursor(const Uint32 type)
 {
     m_cursorType = type;
+    m_fullRedraw = true;
 
     if ((m_cursorType & CURSOR_ARROW) == CURSOR_ARROW)
         if(m_customCursors[0])
@@ -245,6 +432,8 @@ void RWindow::addWidget(RWidget *wgt)
     m_widgets.push_back(wgt);
     m_IDs.push_back(wgt->getID());
     wgt->setWindowSize(m_width, m_height);
+    wgt->setQuad(m_quad);
+    wgt->setWindow(this);
 }
 
 void RWindow::deleteWidget(const unsigned ID)
@@ -257,6 +446,16 @@ void RWindow::deleteWidget(const unsigned ID)
     if(it != m_IDs.end())
     {
         widgetPos = std::distance(m_IDs.begin(), it);
+
+        // The widget's place has to be redrawn without it
+        std::map<RWidget*, SDL_Rect>::iterator drawn = m_drawnRects.find(m_widgets[widgetPos]);
+        if(drawn != m_drawnRects.end())
+        {
+            m_damage.push_back(drawn->second);
+            m_drawnRects.erase(drawn);
+        }
+
+        m_widgets[widgetPos]->setWindow(nullptr);
         m_widgets.erase(m_widgets.begin() + widgetPos);
         m_IDs.erase(m_IDs.begin() + widgetPos);
     }
@@ -267,92 +466,424 @@ void RWindow::deleteWidget(const unsigned ID)
 
 /*virtual*/ void RWindow::update()
 {
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    REALIO_PROFILE_ZONE("RWindow::update");
+
+    m_frameStart = SDL_GetPerformanceCounter();
+    m_frameEvents = m_frameWidgets = 0;
 
-    SDL_Event e;
+    m_gpuTimer->beginFrame();
+    m_frames++;
+
+    // Hand out frames the GPU has finished reading
+    if(m_capture != nullptr)
+        m_capture->collect();
+
+    // Give decoded images to their pixmaps before they are drawn
+    RImageLoader::dispatch();
+    RTextureUploader::process();
 
-    while(SDL_PollEvent(&e))
     {
-        switch(e.type)
+        REALIO_PROFILE_ZONE("RWindow::pollEvents");
+
+        SDL_Event e;
+
+        while(SDL_PollEvent(&e))
         {
-            case SDL_QUIT:
-                //User requests quit
-                quit = true;
-                break;
-            case SDL_APP_TERMINATING:
-                quit = true;
-                break;
-            case SDL_MOUSEMOTION:
-                if ((m_cursorType & CURSOR_ARROW) == CURSOR_ARROW)
-                    if(m_customCursors[0])
-                        m_customCursors[0]->move(e.motion.x, e.motion.y);
-
-                if ((m_cursorType & CURSOR_IBEAM) == CURSOR_IBEAM)
-                    if(m_customCursors[1])
-                        m_customCursors[1]->move(e.motion.x, e.motion.y);
-
-                if ((m_cursorType & CURSOR_WAIT) == CURSOR_WAIT)
-                    if(m_customCursors[2])
-                        m_customCursors[2]->move(e.motion.x, e.motion.y);
-
-                if ((m_cursorType & CURSOR_HAND) == CURSOR_HAND)
-                    if(m_customCursors[3])
-                        m_customCursors[3]->move(e.motion.x, e.motion.y);
+            m_frameEvents++;
+
+            switch(e.type)
+            {
+                case SDL_QUIT:
+                    //User requests quit
+                    quit = true;
+                    break;
+                case SDL_APP_TERMINATING:
+                    quit = true;
+                    break;
+                case SDL_MOUSEMOTION:
+                    if ((m_cursorType & CURSOR_ARROW) == CURSOR_ARROW)
+                        if(m_customCursors[0])
+                            m_customCursors[0]->move(e.motion.x, e.motion.y);
+
+                    if ((m_cursorType & CURSOR_IBEAM) == CURSOR_IBEAM)
+                        if(m_customCursors[1])
+                            m_customCursors[1]->move(e.motion.x, e.motion.y);
+
+                    if ((m_cursorType & CURSOR_WAIT) == CURSOR_WAIT)
+                        if(m_customCursors[2])
+                            m_customCursors[2]->move(e.motion.x, e.motion.y);
+
+                    if ((m_cursorType & CURSOR_HAND) == CURSOR_HAND)
+                        if(m_customCursors[3])
+                            m_customCursors[3]->move(e.motion.x, e.motion.y);
+            }
+
+            if(callback != nullptr)
+                callback(e);
+
+            if(quit)
+            {
+                close();
+                return;
+            }
         }
+    }
+
+    // View and projection are uploaded once for all programs
+    m_cameraBuffer->bind();
+    m_cameraBuffer->update(m_camera, (float)m_width / m_height);
+    glm::mat4 viewProjection = m_cameraBuffer->getViewProjection();
+    m_batch->setViewProjection(viewProjection);
+
+    // Moving the camera moves everything
+    if(viewProjection != m_lastViewProjection)
+    {
+        m_lastViewProjection = viewProjection;
+        m_fullRedraw = true;
+    }
+
+    // Cursors are always in the window's coordinates
+    std::vector<RPixmap*> cursors = getCurrentCursors();
+    for(unsigned i = 0; i < m_widgets.size(); ++i)
+        trackWidget(m_widgets[i], viewProjection);
+    for(unsigned i = 0; i < cursors.size(); ++i)
+        trackWidget(cursors[i], glm::mat4());
+
+    // Nothing has changed, the last frame is still on the screen
+    if(m_damageTracking && !m_fullRedraw && m_damage.empty())
+    {
+        m_frameSkipped = true;
+
+        // The kept frame is still a frame of the recording
+        if(m_capture != nullptr && m_target != nullptr)
+            m_capture->capture(m_target->getFramebuffer());
+
+        finishFrame(true);
+        return;
+    }
+    m_frameSkipped = false;
+
+    // Without a kept frame only the whole window can be redrawn
+    std::vector<SDL_Rect> areas;
+    bool partial = m_damageTracking && !m_fullRedraw && m_target != nullptr && mergeDamage();
+    if(partial)
+        areas = m_damage;
+    else
+    {
+        SDL_Rect window = {0, 0, m_width, m_height};
+        areas.push_back(window);
+    }
+
+    m_damage.clear();
+    m_fullRedraw = false;
+
+    // The target only keeps frames for partial redraws, a headless window has
+    // nothing else to draw to. Whole frames go to the window without a blit
+    RRenderTarget *target = m_damageTracking || m_headless ? m_target : nullptr;
+    if(target != nullptr)
+        target->bind();
+
+    if(partial)
+        glEnable(GL_SCISSOR_TEST);
+
+    // Group widgets by state, keeping the layers' order
+    m_queue->clear();
+    for(unsigned i = 0; i < m_widgets.size(); ++i)
+        m_widgets[i]->enqueue(m_queue);
+    m_queue->sort(m_drawnRects);
+
+    if(m_batching)
+        m_batch->begin();
+
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
-        callback(e);
+    for(unsigned i = 0; i < areas.size(); ++i)
+    {
+        m_gpuTimer->mark(GPU_SCOPE_CLEAR);
+
+        // GL counts rows from the bottom
+        glScissor(areas[i].x, m_height - areas[i].y - areas[i].h, areas[i].w, areas[i].h);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
-        if(quit)
+        m_gpuTimer->mark(GPU_SCOPE_WIDGETS);
+
+        for(unsigned j = 0; j < m_queue->size(); ++j)
         {
-            close();
-            return;
+            RWidget *wgt = m_queue->getWidget(j);
+            if(partial && !isDrawnIn(wgt, areas[i]))
+                continue;
+
+            REALIO_PROFILE_ZONE("RWidget::update");
+            m_frameWidgets++;
+
+            if(m_batching)
+                wgt->submit(m_batch);
+            else
+                wgt->update();
         }
+
+        // The scissor changes with the next area
+        if(m_batching)
+            m_batch->flush();
     }
 
-    for(unsigned i = 0; i < m_widgets.size(); ++i)
-        m_widgets[i]->update();
+    m_gpuTimer->mark(GPU_SCOPE_CURSOR);
+
+    if(m_camera != nullptr)
+    {
+        // The cursor stays in the window's coordinates, the camera's block is left as it is
+        m_cursorBuffer->bind();
+        m_batch->setViewProjection(m_cursorBuffer->getViewProjection());
+    }
+
+    for(unsigned i = 0; i < areas.size(); ++i)
+    {
+        glScissor(areas[i].x, m_height - areas[i].y - areas[i].h, areas[i].w, areas[i].h);
+        drawCursor(areas[i]);
+
+        if(m_batching)
+            m_batch->flush();
+    }
+
+    if(m_batching)
+        m_batch->end();
+
+    glDisable(GL_SCISSOR_TEST);
+
+    m_gpuTimer->mark(GPU_SCOPE_PRESENT);
 
-    drawCursor();
+    if(m_capture != nullptr)
+        m_capture->capture(target != nullptr ? target->getFramebuffer() : 0);
+
+    // Headless frames stay in the render target
+    if(m_headless)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        m_gpuTimer->endFrame();
+        finishFrame(false);
+        return;
+    }
 
-    SDL_UpdateWindowSurface(m_window);
-    SDL_GL_SwapWindow(m_window);
+    if(target != nullptr)
+        target->blit(m_width, m_height);
+
+    {
+        REALIO_PROFILE_ZONE("RWindow::present");
+
+        SDL_UpdateWindowSurface(m_window);
+        SDL_GL_SwapWindow(m_window);
+    }
+
+    m_gpuTimer->endFrame();
+    finishFrame(false);
 }
 
-void RWindow::drawCursor()
+void RWindow::finishFrame(bool skipped)
 {
-    if ((m_cursorType & CURSOR_ARROW) == CURSOR_ARROW)
+    RGLCounters counters = RGLState::getFrameCounters();
+
+    RFrameSample sample;
+    sample.cpuTime = (SDL_GetPerformanceCounter() - m_frameStart) * 1000.0 /
+                     SDL_GetPerformanceFrequency();
+    sample.events = m_frameEvents;
+    sample.widgetsUpdated = m_frameWidgets;
+    sample.drawCalls = counters.drawCalls;
+    sample.programBinds = counters.programBinds;
+    sample.textureBinds = counters.textureBinds;
+    sample.vertexArrayBinds = counters.vertexArrayBinds;
+    sample.triangles = counters.triangles;
+    sample.bufferBytes = counters.bufferBytes;
+    sample.textureBytes = counters.textureBytes;
+    sample.skipped = skipped;
+
+    m_history->push(sample);
+
+    // Textures of every widget on the screen are touched by now
+    RTextureCache::trim();
+
+    // Uploads done between frames, e.g. by show(), belong to the next one
+    RGLState::beginFrame();
+}
+
+void RWindow::trackWidget(RWidget *wgt, const glm::mat4 &viewProjection)
+{
+    SDL_Rect rect = projectRect(viewProjection * wgt->getTransform(), m_width, m_height);
+    std::map<RWidget*, SDL_Rect>::iterator drawn = m_drawnRects.find(wgt);
+
+    if(rect.w > 0 && rect.h > 0)
+        wgt->keepResident();
+
+    if(drawn == m_drawnRects.end())
     {
-        if(m_customCursors[0])
-            m_customCursors[0]->update();
+        // New widgets are drawn first time
+        m_damage.push_back(rect);
+        m_drawnRects[wgt] = rect;
     }
-
-    if ((m_cursorType & CURSOR_IBEAM) == CURSOR_IBEAM)
+    else if(wgt->isDirty() ||
+            rect.x != drawn->second.x || rect.y != drawn->second.y ||
+            rect.w != drawn->second.w || rect.h != drawn->second.h)
     {
-        if(m_customCursors[1])
-            m_customCursors[1]->update();
+        // Both the old and the new places have to be redrawn
+        m_damage.push_back(drawn->second);
+        m_damage.push_back(rect);
+        drawn->second = rect;
     }
 
-    if ((m_cursorType & CURSOR_WAIT) == CURSOR_WAIT)
+    wgt->clearDirty();
+}
+
+bool RWindow::isDrawnIn(RWidget *wgt, const SDL_Rect &area)
+{
+    std::map<RWidget*, SDL_Rect>::iterator drawn = m_drawnRects.find(wgt);
+    return drawn != m_drawnRects.end() && SDL_HasIntersection(&drawn->second, &area);
+}
+
+bool RWindow::mergeDamage()
+{
+    std::vector<SDL_Rect> rects;
+    for(unsigned i = 0; i < m_damage.size(); ++i)
+        if(m_damage[i].w > 0 && m_damage[i].h > 0)
+            rects.push_back(m_damage[i]);
+
+    // Merge until no rectangles overlap, so nothing is drawn twice
+    bool merged = true;
+    while(merged)
     {
-        if(m_customCursors[2])
-            m_customCursors[2]->update();
+        merged = false;
+        for(unsigned i = 0; i < rects.size() && !merged; ++i)
+            for(unsigned j = i + 1; j < rects.size() && !merged; ++j)
+                if(SDL_HasIntersection(&rects[i], &rects[j]))
+                {
+                    SDL_UnionRect(&rects[i], &rects[j], &rects[i]);
+                    rects.erase(rects.begin() + j);
+                    merged = true;
+                }
     }
 
-    if ((m_cursorType & CURSOR_HAND) == CURSOR_HAND)
+    m_damage = rects;
+
+    long area = 0;
+    for(unsigned i = 0; i < rects.size(); ++i)
+        area += (long)rects[i].w * rects[i].h;
+
+    // Scissoring most of the window costs more than it saves
+    return rects.size() <= MAX_DAMAGE_RECTS && area * 2 <= (long)m_width * m_height;
+}
+
+void RWindow::setCamera(RCamera *camera)
+{
+    m_camera = camera;
+    m_fullRedraw = true;
+}
+
+RCamera* RWindow::getCamera()
+{
+    return m_camera;
+}
+
+void RWindow::setDamageTracking(bool enabled)
+{
+    m_damageTracking = enabled;
+    m_fullRedraw = true;
+}
+
+bool RWindow::isFrameSkipped()
+{
+    return m_frameSkipped;
+}
+
+void RWindow::drawCursor(const SDL_Rect &area)
+{
+    std::vector<RPixmap*> cursors = getCurrentCursors();
+
+    for(unsigned i = 0; i < cursors.size(); ++i)
     {
-        if(m_customCursors[3])
-            m_customCursors[3]->update();
+        if(!isDrawnIn(cursors[i], area))
+            continue;
+
+        if(m_batching)
+            cursors[i]->submit(m_batch);
+        else
+            cursors[i]->update();
     }
 }
 
+std::vector<RPixmap*> RWindow::getCurrentCursors()
+{
+    std::vector<RPixmap*> cursors;
+
+    if ((m_cursorType & CURSOR_ARROW) == CURSOR_ARROW && m_customCursors[0])
+        cursors.push_back(m_customCursors[0]);
+
+    if ((m_cursorType & CURSOR_IBEAM) == CURSOR_IBEAM && m_customCursors[1])
+        cursors.push_back(m_customCursors[1]);
+
+    if ((m_cursorType & CURSOR_WAIT) == CURSOR_WAIT && m_customCursors[2])
+        cursors.push_back(m_customCursors[2]);
+
+    if ((m_cursorType & CURSOR_HAND) == CURSOR_HAND && m_customCursors[3])
+        cursors.push_back(m_customCursors[3]);
+
+    return cursors;
+}
+
 bool RWindow::shouldQuit()
 {
-    return quit;
+    return quit || (m_frameLimit > 0 && m_frames >= m_frameLimit);
+}
+
+void RWindow::setFrameLimit(unsigned frames)
+{
+    m_frameLimit = frames;
+}
+
+bool RWindow::isHeadless()
+{
+    return m_headless;
+}
+
+RRenderTarget* RWindow::getRenderTarget()
+{
+    return m_target;
+}
+
+void RWindow::setFrameCapture(RFrameCapture *capture)
+{
+    m_capture = capture;
+}
+
+RFrameCapture* RWindow::getFrameCapture()
+{
+    return m_capture;
+}
+
+RGPUFrameTimes RWindow::getGPUTimes()
+{
+    return m_gpuTimer->getLastFrame();
+}
+
+RFrameStats RWindow::getFrameStats()
+{
+    return m_history->getStats();
+}
+
+void RWindow::setFrameStatsWindow(unsigned frames)
+{
+    m_history->setSize(frames);
 }
 
 void RWindow::setKeyCallback(void (*func)(SDL_Event e))
 {
     callback = func;
 }
+
+void RWindow::setBatching(bool enabled)
+{
+    m_batching = enabled;
+}
+
+RSpriteBatch* RWindow::getSpriteBatch()
+{
+    return m_batch;
+}
 }
@@ -18,19 +18,50 @@
 #define RWINDOW_H
 
 //Realio
+#include "RCamera.h"
+#include "RCameraBuffer.h"
+#include "RFrameCapture.h"
+#include "RFrameStats.h"
+#include "RGPUTimer.h"
 #include "RPixmap.h"
+#include "RRenderQueue.h"
+#include "RRenderTarget.h"
+#include "RSpriteBatch.h"
 //C++
 #include <iostream>
+#include <map>
 #include <string>
 #include <vector>
 //SDL2
 #include <SDL2/SDL.h>
 
 namespace Realio {
+class RTextureAtlas;
+
+//Window modes
+typedef enum
+{
+    WINDOW_FULLSCREEN,                        //Fullscreen window on the desktop
+    WINDOW_HEADLESS                           //Offscreen context without a display
+} RWindowMode;
+
 class RWindow
 {
 public:
+    /**
+     * @brief creates a fullscreen window. If REALIO_HEADLESS is set to WIDTHxHEIGHT,
+     * creates a headless window of that size instead.
+     * @param title of the window.
+     */
     explicit RWindow(const std::string & title);
+
+    /**
+     * @brief creates a window of the given size. Headless windows render into
+     * an offscreen framebuffer through SDL's offscreen video driver.
+     * @param title, width, height and mode of the window.
+     */
+    RWindow(const std::string & title, const int width, const int height,
+            const RWindowMode mode = WINDOW_HEADLESS);
     ~RWindow();
 
     /**
@@ -76,12 +107,21 @@ public:
     void setTitle(const std::string & title);
 
     /**
-     * @brief loads image to use it as cursor later.
+     * @brief loads image to use it as cursor later. The file is looked up
+     * in mounted RAssetPacks first.
      * @param path to a cursor image and type of the setting cursor.
      * @return void.
      */
     void setCursor(const char* filename, const Uint32 type);
 
+    /**
+     * @brief adds images of the custom cursors to the atlas.
+     * Call it after setCursor() and before RTextureAtlas::build().
+     * @param pointer to an RTextureAtlas.
+     * @return void.
+     */
+    void packCursors(RTextureAtlas *atlas);
+
     /**
      * @brief sets cursor to an image.
      * @param type of the cursor.
@@ -124,6 +164,68 @@ public:
      */
     bool shouldQuit();
 
+    /**
+     * @brief makes shouldQuit() return true after the number of updates.
+     * REALIO_FRAME_LIMIT sets it from the environment.
+     * @param number of frames, 0 for no limit.
+     * @return void.
+     */
+    void setFrameLimit(unsigned frames);
+
+    /**
+     * @brief returns true if the window renders without a display.
+     * @param void.
+     * @return true, if the window is headless. false, if not.
+     */
+    bool isHeadless();
+
+    /**
+     * @brief returns the framebuffer frames are rendered into with damage tracking
+     * or in a headless window. Otherwise they go to the window directly.
+     * @param void.
+     * @return pointer to the render target, nullptr if it couldn't be created.
+     */
+    RRenderTarget* getRenderTarget();
+
+    /**
+     * @brief sets the capture every frame is read into. Frames are read before
+     * presenting and delivered a few frames later, so capturing doesn't stall.
+     * The window doesn't take ownership of the capture.
+     * @param pointer to an RFrameCapture of the window's size, nullptr to stop capturing.
+     * @return void.
+     */
+    void setFrameCapture(RFrameCapture *capture);
+
+    /**
+     * @brief returns the window's frame capture.
+     * @param void.
+     * @return pointer to the capture, nullptr if frames aren't captured.
+     */
+    RFrameCapture* getFrameCapture();
+
+    /**
+     * @brief returns GPU timings of the last frame the GPU has finished.
+     * Results lag a few frames behind, because they are never waited for.
+     * @param void.
+     * @return times of the frame's scopes in milliseconds.
+     */
+    RGPUFrameTimes getGPUTimes();
+
+    /**
+     * @brief returns statistics of the last frame and of the rolling window
+     * of recent frames, including a histogram of frame times.
+     * @param void.
+     * @return RFrameStats structure.
+     */
+    RFrameStats getFrameStats();
+
+    /**
+     * @brief sets number of frames in the statistics' rolling window.
+     * @param number of frames.
+     * @return void.
+     */
+    void setFrameStatsWindow(unsigned frames);
+
     /**
      * @brief sets key callback function.
      * @param pointer to a function.
@@ -131,6 +233,51 @@ public:
      */
     void setKeyCallback(void (*func)(SDL_Event e));
 
+    /**
+     * @brief enables or disables drawing widgets through the sprite batch.
+     * @param true to batch widgets, false to draw them one by one.
+     * @return void.
+     */
+    void setBatching(bool enabled);
+
+    /**
+     * @brief returns the window's sprite batch, e.g. to read its counters.
+     * @param void.
+     * @return pointer to the sprite batch.
+     */
+    RSpriteBatch* getSpriteBatch();
+
+    /**
+     * @brief sets the camera the widgets are viewed through. The cursor is
+     * always drawn in the window's coordinates.
+     * @param pointer to an RCamera, nullptr to draw widgets in the window's coordinates.
+     * @return void.
+     */
+    void setCamera(RCamera *camera);
+
+    /**
+     * @brief returns the window's camera.
+     * @param void.
+     * @return pointer to the camera, nullptr if there is no camera.
+     */
+    RCamera* getCamera();
+
+    /**
+     * @brief enables or disables redrawing only the changed parts of the window.
+     * With damage tracking frames without changes aren't drawn at all, without
+     * it they are drawn straight to the window instead of the render target.
+     * @param true to track damage, false to redraw the whole window every frame.
+     * @return void.
+     */
+    void setDamageTracking(bool enabled);
+
+    /**
+     * @brief returns true if the last update() didn't draw anything.
+     * @param void.
+     * @return true, if the frame was skipped. false, if not.
+     */
+    bool isFrameSkipped();
+
 private:
     std::string m_title;
     SDL_Window *m_window;
@@ -144,12 +291,49 @@ private:
     std::vector<RWidget*> m_widgets;
     std::vector<unsigned> m_IDs;
 
+    RQuad *m_quad;
+    RSpriteBatch *m_batch;
+    RRenderQueue *m_queue;
+    bool m_batching;
+
+    RCamera *m_camera;
+    RCameraBuffer *m_cameraBuffer;
+    RCameraBuffer *m_cursorBuffer;
+
+    // Keeps the last frame, so only damaged parts are redrawn
+    RRenderTarget *m_target;
+    bool m_damageTracking;
+    bool m_fullRedraw;
+    bool m_frameSkipped;
+    std::vector<SDL_Rect> m_damage;
+    // Where widgets and cursors were drawn last time
+    std::map<RWidget*, SDL_Rect> m_drawnRects;
+    glm::mat4 m_lastViewProjection;
+
+    RFrameCapture *m_capture;
+    RGPUTimer *m_gpuTimer;
+
+    RFrameHistory *m_history;
+    Uint64 m_frameStart;
+    unsigned m_frameEvents;
+    unsigned m_frameWidgets;
+
     bool quit, m_shown;
+    bool m_headless;
+    unsigned m_frames;
+    unsigned m_frameLimit;
     // Window's width and height
     int m_width, m_height;
 
     void (*callback)(SDL_Event e);
 
+    /**
+     * @brief creates the context and the renderer's objects.
+     * @param void.
+     * @return void.
+     */
+    void initialize();
+
     /**
      * @brief initializes SDL.
      * @param void.
@@ -158,11 +342,47 @@ private:
     bool initializeSDL();
 
     /**
-     * @brief renders the cursor.
+     * @brief renders the current cursors, which overlap the area.
+     * @param area of the window.
+     * @return void.
+     */
+    void drawCursor(const SDL_Rect &area);
+
+    /**
+     * @brief returns the custom cursors of the current type.
+     * @param void.
+     * @return vector of the cursors.
+     */
+    std::vector<RPixmap*> getCurrentCursors();
+
+    /**
+     * @brief compares the widget's place with the last drawn one
+     * and damages both, if the widget has changed.
+     * @param pointer to the widget and the matrix it is viewed through.
+     * @return void.
+     */
+    void trackWidget(RWidget *wgt, const glm::mat4 &viewProjection);
+
+    /**
+     * @brief checks the widget's last drawn place against the area.
+     * @param pointer to the widget and the area.
+     * @return true, if the widget was drawn over the area. false, if not.
+     */
+    bool isDrawnIn(RWidget *wgt, const SDL_Rect &area);
+
+    /**
+     * @brief merges overlapping damaged rectangles.
      * @param void.
+     * @return true, if the damage is worth a partial redraw. false, if not.
+     */
+    bool mergeDamage();
+
+    /**
+     * @brief adds the frame's work to the statistics.
+     * @param true, if the frame was skipped.
      * @return void.
      */
-    void drawCursor();
+    void finishFrame(bool skipped);
 };
 
 //Cursor types
@@ -0,0 +1,428 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#include "../RWindow.h"
+#include "../RAnimatedPixmap.h"
+#include "../RMemoryTracker.h"
+#include "../RMipmapBuilder.h"
+#include "../RTextureAtlas.h"
+#include "../RTextureUploader.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace {
+struct Options {
+    unsigned frames;
+    unsigned count;
+    int width, height;
+    bool atlas;
+    bool async;
+    // Upload budget per frame in KiB, 0 to upload in show()
+    unsigned stream;
+    bool cpuMipmaps;
+    // Run the checks instead of the scenes
+    bool check;
+    std::string scene;
+    std::string sprite;
+    std::string output;
+};
+
+struct Result {
+    std::string scene;
+    unsigned widgets;
+    std::vector<double> times;
+    unsigned drawCalls;
+    unsigned skipped;
+    long residentBytes;
+    size_t textureBytes;
+    size_t bufferBytes;
+};
+
+long residentBytes()
+{
+#ifdef __linux__
+    long pages = 0, resident = 0;
+    std::ifstream statm("/proc/self/statm");
+    if(statm >> pages >> resident)
+        return resident * sysconf(_SC_PAGESIZE);
+#endif
+    return 0;
+}
+
+double percentile(std::vector<double> times, double fraction)
+{
+    if(times.empty())
+        return 0.0;
+
+    std::sort(times.begin(), times.end());
+    size_t index = std::min(times.size() - 1, (size_t)(fraction * times.size()));
+    return times[index];
+}
+
+int randomCoordinate(int max)
+{
+    return std::rand() % (max > 0 ? max : 1);
+}
+
+/**
+ * @brief creates pixmaps at random places of the window.
+ * @param window, options, place for the pixmaps and whether they are animated.
+ * @return atlas the pixmaps are packed into, nullptr if they aren't.
+ */
+/**
+ * @brief loads the sprite into the pixmap, on the loader's threads with --async.
+ * @param pixmap and options.
+ * @return void.
+ */
+void loadSprite(Realio::RPixmap *pixmap, const Options &options)
+{
+    if(options.async)
+        pixmap->loadFileAsync(options.sprite.c_str());
+    else
+        pixmap->loadFile(options.sprite.c_str());
+}
+
+Realio::RTextureAtlas* populate(Realio::RWindow &window, const Options &options,
+                                std::vector<Realio::RPixmap*> &pixmaps, bool animated)
+{
+    Realio::RTextureAtlas *atlas = nullptr;
+    if(options.atlas && !animated)
+        atlas = new Realio::RTextureAtlas;
+
+    for(unsigned i = 0; i < options.count; ++i)
+    {
+        Realio::RPixmap *pixmap;
+        if(animated)
+        {
+            Realio::RAnimatedPixmap *animation = new Realio::RAnimatedPixmap(
+                        randomCoordinate(options.width), randomCoordinate(options.height));
+            animation->loadFile(options.sprite.c_str());
+            animation->loadFile(options.sprite.c_str());
+            pixmap = animation;
+        }
+        else
+        {
+            pixmap = new Realio::RPixmap(randomCoordinate(options.width), randomCoordinate(options.height));
+            // The atlas packs decoded images, so it can't wait for them
+            if(atlas != nullptr)
+                pixmap->loadFile(options.sprite.c_str());
+            else
+                loadSprite(pixmap, options);
+        }
+
+        window.addWidget(pixmap);
+        if(atlas != nullptr)
+            atlas->addPixmap(pixmap);
+        pixmaps.push_back(pixmap);
+    }
+
+    if(atlas != nullptr)
+        atlas->build();
+
+    for(unsigned i = 0; i < pixmaps.size(); ++i)
+        pixmaps[i]->show();
+
+    return atlas;
+}
+
+void clear(Realio::RWindow &window, std::vector<Realio::RPixmap*> &pixmaps)
+{
+    for(unsigned i = 0; i < pixmaps.size(); ++i)
+    {
+        window.deleteWidget(pixmaps[i]->getID());
+        delete pixmaps[i];
+    }
+    pixmaps.clear();
+}
+
+/**
+ * @brief runs one scene and measures every frame.
+ * @param window, options and name of the scene.
+ * @return measured frames.
+ */
+Result runScene(Realio::RWindow &window, const Options &options, const std::string &scene)
+{
+    Result result;
+    result.scene = scene;
+    result.widgets = options.count;
+    result.drawCalls = 0;
+    result.skipped = 0;
+
+    std::vector<Realio::RPixmap*> pixmaps;
+    Realio::RTextureAtlas *atlas = populate(window, options, pixmaps, scene == "animated");
+
+    // The first frame uploads everything, it isn't a part of the scene
+    window.update();
+    glFinish();
+
+    double frequency = (double)SDL_GetPerformanceFrequency();
+
+    for(unsigned frame = 0; frame < options.frames; ++frame)
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+
+        if(scene == "moving")
+        {
+            for(unsigned i = 0; i < pixmaps.size(); ++i)
+                pixmaps[i]->move((pixmaps[i]->getXPos() + 3) % options.width,
+                                 (pixmaps[i]->getYPos() + 2) % options.height);
+        }
+        else if(scene == "animated")
+        {
+            for(unsigned i = 0; i < pixmaps.size(); ++i)
+                static_cast<Realio::RAnimatedPixmap*>(pixmaps[i])->nextFrame();
+        }
+        else if(scene == "churn")
+        {
+            // Replace a tenth of the widgets every frame
+            unsigned replaced = std::max(1u, options.count / 10);
+            for(unsigned i = 0; i < replaced && !pixmaps.empty(); ++i)
+            {
+                unsigned index = std::rand() % pixmaps.size();
+                window.deleteWidget(pixmaps[index]->getID());
+                delete pixmaps[index];
+
+                pixmaps[index] = new Realio::RPixmap(randomCoordinate(options.width),
+                                                     randomCoordinate(options.height));
+                loadSprite(pixmaps[index], options);
+                window.addWidget(pixmaps[index]);
+                pixmaps[index]->show();
+            }
+        }
+
+        window.update();
+
+        // Count the GPU's work in the frame, not only its submission
+        glFinish();
+
+        result.times.push_back((SDL_GetPerformanceCounter() - start) * 1000.0 / frequency);
+        if(window.isFrameSkipped())
+            result.skipped++;
+        else
+            result.drawCalls += window.getSpriteBatch()->getDrawCalls();
+    }
+
+    result.residentBytes = residentBytes();
+    result.textureBytes = Realio::RMemoryTracker::getBytes(Realio::MEMORY_TEXTURES);
+    result.bufferBytes = Realio::RMemoryTracker::getBytes(Realio::MEMORY_BUFFERS);
+    clear(window, pixmaps);
+    delete atlas;
+
+    return result;
+}
+
+/**
+ * @brief loads the sprite into pixmaps, which are already atlased, synchronously
+ * and asynchronously. Both must draw the whole new texture afterwards.
+ * @param window and options.
+ * @return true, if the check passes.
+ */
+bool checkAtlasReload(Realio::RWindow &window, const Options &options)
+{
+    const glm::vec4 whole(0.0f, 0.0f, 1.0f, 1.0f);
+    bool passed = true;
+
+    for(int async = 0; async < 2; ++async)
+    {
+        Realio::RTextureAtlas atlas;
+        Realio::RPixmap *pixmap = new Realio::RPixmap(0, 0);
+        pixmap->loadFile(options.sprite.c_str());
+        window.addWidget(pixmap);
+        atlas.addPixmap(pixmap);
+        atlas.build();
+        pixmap->show();
+        window.update();
+
+        bool atlased = pixmap->isAtlased();
+
+        if(async)
+            pixmap->loadFileAsync(options.sprite.c_str());
+        else
+            pixmap->loadFile(options.sprite.c_str());
+        pixmap->show();
+
+        for(unsigned frame = 0; frame < 600 && pixmap->isLoading(); ++frame)
+            window.update();
+        window.update();
+
+        bool reloaded = !pixmap->isAtlased() && pixmap->getUvRect() == whole;
+        std::cout << "atlas reload (" << (async ? "async" : "sync") << "): " <<
+                     (atlased && reloaded ? "passed" : "FAILED") << std::endl;
+        passed = passed && atlased && reloaded;
+
+        window.deleteWidget(pixmap->getID());
+        delete pixmap;
+    }
+
+    return passed;
+}
+
+std::string toJson(const Options &options, const std::vector<Result> &results)
+{
+    std::ostringstream out;
+    out.precision(4);
+    out << std::fixed;
+
+    out << "{\n  \"width\": " << options.width << ",\n  \"height\": " << options.height <<
+           ",\n  \"atlas\": " << (options.atlas ? "true" : "false") <<
+           ",\n  \"async\": " << (options.async ? "true" : "false") <<
+           ",\n  \"stream_kib\": " << options.stream <<
+           ",\n  \"cpu_mipmaps\": " << (options.cpuMipmaps ? "true" : "false") << ",\n  \"scenes\": [";
+
+    for(unsigned i = 0; i < results.size(); ++i)
+    {
+        const Result &result = results[i];
+        double mean = 0.0;
+        for(unsigned j = 0; j < result.times.size(); ++j)
+            mean += result.times[j];
+        if(!result.times.empty())
+            mean /= result.times.size();
+
+        unsigned drawn = result.times.size() - result.skipped;
+
+        out << (i ? "," : "") << "\n    {\"scene\": \"" << result.scene << "\"" <<
+               ", \"widgets\": " << result.widgets <<
+               ", \"frames\": " << result.times.size() <<
+               ", \"skipped_frames\": " << result.skipped <<
+               ", \"mean_ms\": " << mean <<
+               ", \"p50_ms\": " << percentile(result.times, 0.5) <<
+               ", \"p99_ms\": " << percentile(result.times, 0.99) <<
+               ", \"max_ms\": " << percentile(result.times, 1.0) <<
+               ", \"draw_calls\": " << (drawn ? (double)result.drawCalls / drawn : 0.0) <<
+               ", \"resident_bytes\": " << result.residentBytes <<
+               ", \"texture_bytes\": " << result.textureBytes <<
+               ", \"buffer_bytes\": " << result.bufferBytes << "}";
+    }
+
+    out << "\n  ]\n}\n";
+    return out.str();
+}
+
+void usage()
+{
+    std::cerr << "Usage: realio_bench [--frames N] [--count N] [--size WIDTHxHEIGHT]\n"
+                 "                    [--scene static|moving|animated|churn] [--atlas]\n"
+                 "                    [--async] [--stream KIB] [--cpu-mipmaps]\n"
+                 "                    [--sprite PATH] [--output PATH] [--check]\n";
+}
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    options.frames = 600;
+    options.count = 1000;
+    options.width = 1280;
+    options.height = 720;
+    options.atlas = false;
+    options.async = false;
+    options.stream = 0;
+    options.cpuMipmaps = false;
+    options.check = false;
+    options.sprite = "cursor.png";
+
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if(arg == "--frames" && hasValue)
+            options.frames = std::strtoul(argv[++i], nullptr, 10);
+        else if(arg == "--count" && hasValue)
+            options.count = std::strtoul(argv[++i], nullptr, 10);
+        else if(arg == "--size" && hasValue)
+        {
+            if(std::sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2)
+            {
+                usage();
+                return 1;
+            }
+        }
+        else if(arg == "--scene" && hasValue)
+            options.scene = argv[++i];
+        else if(arg == "--sprite" && hasValue)
+            options.sprite = argv[++i];
+        else if(arg == "--output" && hasValue)
+            options.output = argv[++i];
+        else if(arg == "--atlas")
+            options.atlas = true;
+        else if(arg == "--async")
+            options.async = true;
+        else if(arg == "--stream" && hasValue)
+            options.stream = std::strtoul(argv[++i], nullptr, 10);
+        else if(arg == "--cpu-mipmaps")
+            options.cpuMipmaps = true;
+        else if(arg == "--check")
+            options.check = true;
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    const char *scenes[] = {"static", "moving", "animated", "churn"};
+
+    // Same scenes place widgets the same way in every run
+    std::srand(1);
+
+    Realio::RWindow window("realio_bench", options.width, options.height, Realio::WINDOW_HEADLESS);
+    window.show();
+
+    Realio::RMipmapBuilder::setEnabled(options.cpuMipmaps);
+
+    if(options.stream > 0)
+    {
+        Realio::RTextureUploader::setEnabled(true);
+        Realio::RTextureUploader::setBudget(options.stream * 1024, 2.0);
+    }
+
+    if(options.check)
+        return checkAtlasReload(window, options) ? 0 : 1;
+
+    std::vector<Result> results;
+    for(unsigned i = 0; i < 4; ++i)
+        if(options.scene.empty() || options.scene == scenes[i])
+            results.push_back(runScene(window, options, scenes[i]));
+
+    if(results.empty())
+    {
+        usage();
+        return 1;
+    }
+
+    std::string json = toJson(options, results);
+
+    if(options.output.empty())
+        std::cout << json;
+    else
+    {
+        std::ofstream file(options.output.c_str());
+        file << json;
+    }
+
+    return 0;
+}
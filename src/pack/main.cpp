@@ -0,0 +1,52 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#include "../RAssetPack.h"
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char *argv[])
+{
+    bool compress = true;
+    const char *output = nullptr;
+    std::vector<std::string> files;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        if(std::strcmp(argv[i], "--store") == 0)
+            compress = false;
+        else if(output == nullptr)
+            output = argv[i];
+        else
+            files.push_back(argv[i]);
+    }
+
+    if(output == nullptr || files.empty())
+    {
+        std::cerr << "Usage: " << argv[0] << " [--store] output.rpak file..." << std::endl;
+        std::cerr << "Packs the files under their paths as given, so run it from the "
+                     "directory the game loads them relative to. --store skips compression." << std::endl;
+        return 1;
+    }
+
+    if(!Realio::RAssetPack::write(output, files, compress))
+        return 1;
+
+    std::cout << files.size() << " files -> " << output << std::endl;
+    return 0;
+}
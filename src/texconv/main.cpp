@@ -0,0 +1,49 @@
+/**
+ * This file is part of Realio.
+ * Realio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2015 Sergey Popov <sergobot@vivaldi.net>
+**/
+
+#include "../RTextureFile.h"
+#include "../stb/stb_image.h"
+#include <iostream>
+
+int main(int argc, char *argv[])
+{
+    if(argc != 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " input.png output.rtex" << std::endl;
+        std::cerr << "Converts an image into a texture file with its mipmaps, "
+                     "which RPixmap::loadFile() maps without decoding." << std::endl;
+        return 1;
+    }
+
+    int width, height, components;
+    unsigned char *image = stbi_load(argv[1], &width, &height, &components, STBI_rgb_alpha);
+    if(!image)
+    {
+        const char *reason = stbi_failure_reason();
+        std::cerr << "Could not load image '" << argv[1] << "': " <<
+                     (reason != nullptr ? reason : "unknown error") << std::endl;
+        return 1;
+    }
+
+    bool written = Realio::RTextureFile::write(argv[2], image, width, height);
+    stbi_image_free(image);
+
+    if(!written)
+        return 1;
+
+    std::cout << argv[1] << " -> " << argv[2] << " (" << width << "x" << height << ")" << std::endl;
+    return 0;
+}